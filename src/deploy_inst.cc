@@ -9,30 +9,10 @@ DeployInst::~DeployInst() {}
 
 void DeployInst::Build(cyclus::Agent* parent) {
   cyclus::Institution::Build(parent);
-  BuildSched::iterator it;
-  std::set<std::string> protos;
   for (int i = 0; i < prototypes.size(); i++) {
     std::string proto = prototypes[i];
-
-    std::stringstream ss;
-    ss << proto;
-
     if (lifetimes.size() == prototypes.size()) {
-      cyclus::Agent* a = context()->CreateAgent<Agent>(proto);
-      if (a->lifetime() != lifetimes[i]) {
-        a->lifetime(lifetimes[i]);
-
-        if (lifetimes[i] == -1) {
-          ss << "_life_forever";
-        } else {
-          ss << "_life_" << lifetimes[i];
-        }
-        proto = ss.str();
-        if (protos.count(proto) == 0) {
-          protos.insert(proto);
-          context()->AddPrototype(proto, a);
-        }
-      }
+      proto = LifetimeProto_(proto, lifetimes[i]);
     }
 
     int t = build_times[i];
@@ -42,6 +22,46 @@ void DeployInst::Build(cyclus::Agent* parent) {
   }
 }
 
+std::string DeployInst::LifetimeProto_(std::string proto, int lifetime) {
+  std::pair<std::string, int> key(proto, lifetime);
+  std::map<std::pair<std::string, int>, std::string>::iterator it =
+      lifetime_protos_.find(key);
+  if (it != lifetime_protos_.end()) {
+    return it->second;
+  }
+
+  // the prototype's own lifetime is only looked up once
+  std::map<std::string, int>::iterator life = proto_lifetimes_.find(proto);
+  cyclus::Agent* a = NULL;
+  if (life == proto_lifetimes_.end()) {
+    a = context()->CreateAgent<Agent>(proto);
+    life = proto_lifetimes_.insert(std::make_pair(proto, a->lifetime())).first;
+  }
+
+  std::string name = proto;
+  if (life->second != lifetime) {
+    if (a == NULL) {
+      a = context()->CreateAgent<Agent>(proto);
+    }
+    a->lifetime(lifetime);
+
+    std::stringstream ss;
+    ss << proto;
+    if (lifetime == -1) {
+      ss << "_life_forever";
+    } else {
+      ss << "_life_" << lifetime;
+    }
+    name = ss.str();
+    context()->AddPrototype(name, a);
+  } else if (a != NULL) {
+    // the probe was only needed to read the prototype's lifetime
+    context()->DelAgent(a);
+  }
+  lifetime_protos_[key] = name;
+  return name;
+}
+
 void DeployInst::EnterNotify() {
   cyclus::Institution::EnterNotify();
   int n = prototypes.size();
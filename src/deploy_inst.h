@@ -81,6 +81,18 @@ class DeployInst : public cyclus::Institution {
     "uilabel": "Lifetimes" \
   }
   std::vector<int> lifetimes;
+
+ private:
+  /// Returns the name of the prototype to build for proto with the given
+  /// lifetime, registering a '_life_[lifetime]' prototype the first time a
+  /// lifetime differing from proto's own is asked for.
+  std::string LifetimeProto_(std::string proto, int lifetime);
+
+  // prototype registrations made by LifetimeProto_ - no need to be state
+  // vars.  lifetime_protos_ maps (prototype, lifetime) to the prototype name
+  // to build and proto_lifetimes_ holds each prototype's own lifetime.
+  std::map<std::pair<std::string, int>, std::string> lifetime_protos_;
+  std::map<std::string, int> proto_lifetimes_;
 };
 
 }  // namespace cycamore
@@ -138,6 +138,50 @@ TEST(DeployInstTests, NoDupProtos) {
   EXPECT_EQ(1, stmt->GetInt(0));
 }
 
+TEST(DeployInstTests, SharedLifetimeProtos) {
+  // entries sharing a prototype and lifetime all get built, and each
+  // prototype/lifetime pair is registered only once
+  std::string config = 
+     "<prototypes>  <val>foo</val> <val>bar</val> <val>foo</val> <val>foo</val> <val>bar</val> </prototypes>"
+     "<build_times> <val>1</val>   <val>1</val>   <val>1</val>   <val>2</val>   <val>1</val>   </build_times>"
+     "<n_build>     <val>2</val>   <val>1</val>   <val>3</val>   <val>4</val>   <val>5</val>   </n_build>"
+     "<lifetimes>   <val>2</val>   <val>-1</val>  <val>2</val>   <val>2</val>   <val>3</val>   </lifetimes>"
+     ;
+
+  int simdur = 5;
+  cyclus::MockSim sim(cyclus::AgentSpec(":cycamore:DeployInst"), config, simdur);
+  sim.DummyProto("foo");
+  sim.DummyProto("bar");
+  int id = sim.Run();
+
+  cyclus::SqlStatement::Ptr stmt = sim.db().db().Prepare(
+      "SELECT COUNT(*) FROM AgentEntry WHERE Prototype = 'foo_life_2' AND EnterTime = 1;"
+      );
+  stmt->Step();
+  EXPECT_EQ(5, stmt->GetInt(0));
+  stmt = sim.db().db().Prepare(
+      "SELECT COUNT(*) FROM AgentEntry WHERE Prototype = 'foo_life_2' AND EnterTime = 2;"
+      );
+  stmt->Step();
+  EXPECT_EQ(4, stmt->GetInt(0));
+  stmt = sim.db().db().Prepare(
+      "SELECT COUNT(*) FROM AgentEntry WHERE Prototype = 'bar';"
+      );
+  stmt->Step();
+  EXPECT_EQ(1, stmt->GetInt(0));
+  stmt = sim.db().db().Prepare(
+      "SELECT COUNT(*) FROM AgentEntry WHERE Prototype = 'bar_life_3';"
+      );
+  stmt->Step();
+  EXPECT_EQ(5, stmt->GetInt(0));
+
+  stmt = sim.db().db().Prepare(
+      "SELECT COUNT(*) FROM Prototypes WHERE Prototype = 'foo_life_2';"
+      );
+  stmt->Step();
+  EXPECT_EQ(1, stmt->GetInt(0));
+}
+
 // required to get functionality in cyclus agent unit tests library
 cyclus::Agent* DeployInstitutionConstructor(cyclus::Context* ctx) {
   return new cycamore::DeployInst(ctx);
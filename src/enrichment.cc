@@ -179,15 +179,15 @@ std::set<cyclus::BidPortfolio<cyclus::Material>::Ptr> Enrichment::GetMatlBids(
     std::vector<Request<Material>*>& tails_requests =
         out_requests[tails_commod];
     std::vector<Request<Material>*>::iterator it;
-    for (it = tails_requests.begin(); it != tails_requests.end(); ++it) {
-      // offer bids for all tails material, keeping discrete quantities
-      // to preserve possible variation in composition
-      MatVec mats = tails.PopN(tails.count());
-      tails.Push(mats);
-      for (int k = 0; k < mats.size(); k++) {
-        Material::Ptr m = mats[k];
-        Request<Material>* req = *it;
-        tails_port->AddBid(req, m, this);
+    // offer bids for all tails material, keeping discrete quantities
+    // to preserve possible variation in composition.  The buffer is only
+    // copied out once for all requests.
+    MatVec mats = tails.PopN(tails.count());
+    tails.Push(mats);
+    for (int k = 0; k < mats.size(); k++) {
+      Material::Ptr m = mats[k];
+      for (it = tails_requests.begin(); it != tails_requests.end(); ++it) {
+        tails_port->AddBid(*it, m, this);
       }
     }
     // overbidding (bidding on every offer)
@@ -12,126 +12,81 @@ using pyne::simple_xs;
 
 namespace cycamore {
 
-class FissConverter : public cyclus::Converter<cyclus::Material> {
- public:
-  FissConverter(Composition::Ptr c_fill, Composition::Ptr c_fiss,
-                Composition::Ptr c_topup, std::string spectrum)
-      : c_fiss_(c_fiss), c_topup_(c_topup), c_fill_(c_fill), spec_(spectrum) {
-    w_fiss_ = CosiWeight(c_fiss, spectrum);
-    w_fill_ = CosiWeight(c_fill, spectrum);
-    w_topup_ = CosiWeight(c_topup, spectrum);
+// Input streams FuelFab blends from.  Fill is mixed with fiss when their
+// weights span the target; otherwise fiss stands in as the filler and is
+// mixed with topup.
+enum Stream { FILL = 0, FISS, TOPUP, N_STREAMS };
+
+// Solves for the mass fraction of each stream (indexed by Stream) needed to
+// make a material with weight w_tgt.  Topup is only considered if use_topup is
+// set.  Returns false if neither stream pair can meet the target.
+static bool MixFracs(const Composition::Ptr comps[N_STREAMS],
+                     const double weights[N_STREAMS], double w_tgt,
+                     bool use_topup, double fracs[N_STREAMS]) {
+  int low;
+  int high;
+  if (ValidWeights(weights[FILL], w_tgt, weights[FISS])) {
+    low = FILL;
+    high = FISS;
+  } else if (use_topup && ValidWeights(weights[FISS], w_tgt, weights[TOPUP])) {
+    low = FISS;
+    high = TOPUP;
+  } else {
+    return false;
   }
 
-  virtual ~FissConverter() {}
-
-  virtual double convert(
-      cyclus::Material::Ptr m, cyclus::Arc const* a = NULL,
-      cyclus::ExchangeTranslationContext<cyclus::Material> const* ctx =
-          NULL) const {
-    double w_tgt = CosiWeight(m->comp(), spec_);
-    if (ValidWeights(w_fill_, w_tgt, w_fiss_)) {
-      double frac = HighFrac(w_fill_, w_tgt, w_fiss_);
-      return AtomToMassFrac(frac, c_fiss_, c_fill_) * m->quantity();
-    } else if (ValidWeights(w_fiss_, w_tgt, w_topup_)) {
-      // use fiss inventory as filler, and topup as fissile
-      double frac = LowFrac(w_fiss_, w_tgt, w_topup_);
-      return AtomToMassFrac(frac, c_fiss_, c_topup_) * m->quantity();
-    } else {
-      // don't bid at all
-      return 1e200;
-    }
+  double f = HighFrac(weights[low], w_tgt, weights[high]);
+  for (int i = 0; i < N_STREAMS; i++) {
+    fracs[i] = 0;
   }
+  fracs[high] = AtomToMassFrac(f, comps[high], comps[low]);
+  fracs[low] = AtomToMassFrac(1 - f, comps[low], comps[high]);
+  return true;
+}
 
- private:
-  std::string spec_;
-  double w_fiss_;
-  double w_topup_;
-  double w_fill_;
-  Composition::Ptr c_fiss_;
-  Composition::Ptr c_fill_;
-  Composition::Ptr c_topup_;
-};
-
-class FillConverter : public cyclus::Converter<cyclus::Material> {
+// StreamConverter converts a requested material into the quantity of a
+// single input stream that is needed to make it.
+class StreamConverter : public cyclus::Converter<cyclus::Material> {
  public:
-  FillConverter(Composition::Ptr c_fill, Composition::Ptr c_fiss,
-                Composition::Ptr c_topup, std::string spectrum)
-      : c_fiss_(c_fiss), c_topup_(c_topup), c_fill_(c_fill), spec_(spectrum) {
-    w_fiss_ = CosiWeight(c_fiss, spectrum);
-    w_fill_ = CosiWeight(c_fill, spectrum);
-    w_topup_ = CosiWeight(c_topup, spectrum);
-  }
-
-  virtual ~FillConverter() {}
-
-  virtual double convert(
-      cyclus::Material::Ptr m, cyclus::Arc const* a = NULL,
-      cyclus::ExchangeTranslationContext<cyclus::Material> const* ctx =
-          NULL) const {
-    double w_tgt = CosiWeight(m->comp(), spec_);
-    if (ValidWeights(w_fill_, w_tgt, w_fiss_)) {
-      double frac = LowFrac(w_fill_, w_tgt, w_fiss_);
-      return AtomToMassFrac(frac, c_fill_, c_fiss_) * m->quantity();
-    } else if (ValidWeights(w_fiss_, w_tgt, w_topup_)) {
-      // switched fissile inventory to filler so don't need any filler inventory
-      return 0;
-    } else {
-      // don't bid at all
-      return 1e200;
+  StreamConverter(const Composition::Ptr comps[N_STREAMS],
+                  const double weights[N_STREAMS], bool use_topup,
+                  Stream stream, Spectrum spectrum)
+      : use_topup_(use_topup), stream_(stream), spec_(spectrum) {
+    for (int i = 0; i < N_STREAMS; i++) {
+      comps_[i] = comps[i];
+      weights_[i] = weights[i];
     }
   }
 
- private:
-  std::string spec_;
-  double w_fiss_;
-  double w_topup_;
-  double w_fill_;
-  Composition::Ptr c_fiss_;
-  Composition::Ptr c_fill_;
-  Composition::Ptr c_topup_;
-};
-
-class TopupConverter : public cyclus::Converter<cyclus::Material> {
- public:
-  TopupConverter(Composition::Ptr c_fill, Composition::Ptr c_fiss,
-                 Composition::Ptr c_topup, std::string spectrum)
-      : c_fiss_(c_fiss), c_topup_(c_topup), c_fill_(c_fill), spec_(spectrum) {
-    w_fiss_ = CosiWeight(c_fiss, spectrum);
-    w_fill_ = CosiWeight(c_fill, spectrum);
-    w_topup_ = CosiWeight(c_topup, spectrum);
-  }
-
-  virtual ~TopupConverter() {}
+  virtual ~StreamConverter() {}
 
   virtual double convert(
       cyclus::Material::Ptr m, cyclus::Arc const* a = NULL,
       cyclus::ExchangeTranslationContext<cyclus::Material> const* ctx =
           NULL) const {
+    double fracs[N_STREAMS];
     double w_tgt = CosiWeight(m->comp(), spec_);
-    if (ValidWeights(w_fill_, w_tgt, w_fiss_)) {
-      return 0;
-    } else if (ValidWeights(w_fiss_, w_tgt, w_topup_)) {
-      // switched fissile inventory to filler and topup as fissile
-      double frac = HighFrac(w_fiss_, w_tgt, w_topup_);
-      return AtomToMassFrac(frac, c_topup_, c_fiss_) * m->quantity();
-    } else {
+    if (!MixFracs(comps_, weights_, w_tgt, use_topup_, fracs)) {
       // don't bid at all
       return 1e200;
     }
+    return fracs[stream_] * m->quantity();
   }
 
  private:
-  std::string spec_;
-  double w_fiss_;
-  double w_topup_;
-  double w_fill_;
-  Composition::Ptr c_fiss_;
-  Composition::Ptr c_fill_;
-  Composition::Ptr c_topup_;
+  Composition::Ptr comps_[N_STREAMS];
+  double weights_[N_STREAMS];
+  bool use_topup_;
+  Stream stream_;
+  Spectrum spec_;
 };
 
 FuelFab::FuelFab(cyclus::Context* ctx)
-    : cyclus::Facility(ctx), fill_size(0), fiss_size(0), throughput(0) {}
+    : cyclus::Facility(ctx),
+      fill_size(0),
+      fiss_size(0),
+      throughput(0),
+      spec_(THERMAL) {}
 
 void FuelFab::EnterNotify() {
   cyclus::Facility::EnterNotify();
@@ -157,6 +112,8 @@ void FuelFab::EnterNotify() {
        << " fill_commod_prefs vals, expected " << fill_commods.size();
     throw cyclus::ValidationError(ss.str());
   }
+
+  spec_ = ToSpectrum(spectrum);
 }
 
 std::set<cyclus::RequestPortfolio<Material>::Ptr> FuelFab::GetMatlRequests() {
@@ -223,6 +180,20 @@ std::set<cyclus::RequestPortfolio<Material>::Ptr> FuelFab::GetMatlRequests() {
   return ports;
 }
 
+// IMPORTANT - each buffer needs to be a single homogenous composition or the
+// inventory mixing constraints for bids don't work.  Blend absorbs m into the
+// material already held in buf, so each arrival only costs a merge with the
+// one resident material rather than re-squashing the whole buffer.
+void Blend(cyclus::toolkit::ResBuf<Material>* buf, Material::Ptr m) {
+  if (buf->count() == 0) {
+    buf->Push(m);
+    return;
+  }
+  Material::Ptr resident = buf->Pop();
+  resident->Absorb(m);
+  buf->Push(resident);
+}
+
 bool Contains(std::vector<std::string> vec, std::string s) {
   for (int i = 0; i < vec.size(); i++) {
     if (vec[i] == s) {
@@ -244,29 +215,17 @@ void FuelFab::AcceptMatlTrades(
     cyclus::Request<Material>* req = trade->first.request;
     Material::Ptr m = trade->second;
     if (req_inventories_[req] == "fill") {
-      fill.Push(m);
+      Blend(&fill, m);
     } else if (req_inventories_[req] == "topup") {
-      topup.Push(m);
+      Blend(&topup, m);
     } else if (req_inventories_[req] == "fiss") {
-      fiss.Push(m);
+      Blend(&fiss, m);
     } else {
       throw cyclus::ValueError("cycamore::FuelFab was overmatched on requests");
     }
   }
 
   req_inventories_.clear();
-
-  // IMPORTANT - each buffer needs to be a single homogenous composition or
-  // the inventory mixing constraints for bids don't work
-  if (fill.count() > 1) {
-    fill.Push(cyclus::toolkit::Squash(fill.PopN(fill.count())));
-  }
-  if (fiss.count() > 1) {
-    fiss.Push(cyclus::toolkit::Squash(fiss.PopN(fiss.count())));
-  }
-  if (topup.count() > 1) {
-    topup.Push(cyclus::toolkit::Squash(topup.PopN(topup.count())));
-  }
 }
 
 std::set<cyclus::BidPortfolio<Material>::Ptr> FuelFab::GetMatlBids(
@@ -282,101 +241,106 @@ std::set<cyclus::BidPortfolio<Material>::Ptr> FuelFab::GetMatlBids(
     return ports;
   }
 
-  double w_fill = 0;
   Composition::Ptr
       c_fill;  // no default needed - this is non-optional parameter
   if (fill.count() > 0) {
     c_fill = fill.Peek()->comp();
-    w_fill = CosiWeight(c_fill, spectrum);
   } else {
     c_fill = context()->GetRecipe(fill_recipe);
-    w_fill = CosiWeight(c_fill, spectrum);
   }
 
-  double w_topup = 0;
   Composition::Ptr c_topup = c_fill;
   if (topup.count() > 0) {
     c_topup = topup.Peek()->comp();
-    w_topup = CosiWeight(c_topup, spectrum);
   } else if (!topup_recipe.empty()) {
     c_topup = context()->GetRecipe(topup_recipe);
-    w_topup = CosiWeight(c_topup, spectrum);
   }
 
-  double w_fiss =
-      w_fill;  // this allows trading just fill with no fiss inventory
+  // this allows trading just fill with no fiss inventory
   Composition::Ptr c_fiss = c_fill;
   if (fiss.count() > 0) {
     c_fiss = fiss.Peek()->comp();
-    w_fiss = CosiWeight(c_fiss, spectrum);
   } else if (!fiss_recipe.empty()) {
     c_fiss = context()->GetRecipe(fiss_recipe);
-    w_fiss = CosiWeight(c_fiss, spectrum);
   }
 
+  Composition::Ptr comps[N_STREAMS] = {c_fill, c_fiss, c_topup};
+  double weights[N_STREAMS];
+  for (int i = 0; i < N_STREAMS; i++) {
+    weights[i] = CosiWeight(comps[i], spec_);
+  }
+  // only bid with topup if we have it - otherwise we might be able to meet
+  // target with filler when we get it. we should only use topup when the
+  // fissile has too poor neutronics.
+  bool use_topup = topup.count() > 0;
+
+  // Requests are grouped by target composition (e.g. many reactors ordering
+  // the same recipe) so the mixing solution for each distinct target is only
+  // computed once per time step.  Each group maps to a unit quantity mixed
+  // material whose composition is shared by all offers in the group - or to
+  // a null pointer if the input streams can't meet the target weight.
+  std::map<int, Material::Ptr> mixes;
+  std::map<std::pair<int, double>, Material::Ptr> offers;
+
   BidPortfolio<Material>::Ptr port(new BidPortfolio<Material>());
   for (int j = 0; j < reqs.size(); j++) {
     cyclus::Request<Material>* req = reqs[j];
 
     Composition::Ptr tgt = req->target()->comp();
-    double w_tgt = CosiWeight(tgt, spectrum);
     double tgt_qty = req->target()->quantity();
-    if (ValidWeights(w_fill, w_tgt, w_fiss)) {
-      double fiss_frac = HighFrac(w_fill, w_tgt, w_fiss);
-      double fill_frac = 1 - fiss_frac;
-      fiss_frac = AtomToMassFrac(fiss_frac, c_fiss, c_fill);
-      fill_frac = AtomToMassFrac(fill_frac, c_fill, c_fiss);
-      Material::Ptr m1 = Material::CreateUntracked(fiss_frac * tgt_qty, c_fiss);
-      Material::Ptr m2 = Material::CreateUntracked(fill_frac * tgt_qty, c_fill);
-      m1->Absorb(m2);
-
-      bool exclusive = false;
-      port->AddBid(req, m1, this, exclusive);
-    } else if (topup.count() > 0 && ValidWeights(w_fiss, w_tgt, w_topup)) {
-      // only bid with topup if we have filler - otherwise we might be able to
-      // meet target with filler when we get it. we should only use topup
-      // when the fissile has too poor neutronics.
-      double topup_frac = HighFrac(w_fiss, w_tgt, w_topup);
-      double fiss_frac = 1 - topup_frac;
-      fiss_frac = AtomToMassFrac(fiss_frac, c_fiss, c_topup);
-      topup_frac = AtomToMassFrac(topup_frac, c_topup, c_fiss);
-      Material::Ptr m1 =
-          Material::CreateUntracked(topup_frac * tgt_qty, c_topup);
-      Material::Ptr m2 = Material::CreateUntracked(fiss_frac * tgt_qty, c_fiss);
-      m1->Absorb(m2);
-
-      bool exclusive = false;
-      port->AddBid(req, m1, this, exclusive);
-    } else if (fiss.count() > 0 && fill.count() > 0 ||
-               fiss.count() > 0 && topup.count() > 0) {
-      // else can't meet the target weight - don't bid.  Just a plain else
-      // doesn't work because we set w_fiss = w_fill if we don't have any fiss
-      // or fill inventory.
-      std::stringstream ss;
-      ss << "prototype '" << prototype()
-         << "': Input stream weights/reactivity do not span "
-            "the requested material weight.";
-      cyclus::Warn<cyclus::VALUE_WARNING>(ss.str());
+    std::map<int, Material::Ptr>::iterator mix = mixes.find(tgt->id());
+    if (mix == mixes.end()) {
+      Material::Ptr m1;
+      double fracs[N_STREAMS];
+      double w_tgt = CosiWeight(tgt, spec_);
+      if (MixFracs(comps, weights, w_tgt, use_topup, fracs)) {
+        for (int i = 0; i < N_STREAMS; i++) {
+          if (fracs[i] <= 0) {
+            continue;
+          } else if (!m1) {
+            m1 = Material::CreateUntracked(fracs[i], comps[i]);
+          } else {
+            m1->Absorb(Material::CreateUntracked(fracs[i], comps[i]));
+          }
+        }
+      } else if (fiss.count() > 0 && fill.count() > 0 ||
+                 fiss.count() > 0 && topup.count() > 0) {
+        // else can't meet the target weight - don't bid.  Just a plain else
+        // doesn't work because we set c_fiss = c_fill if we don't have any
+        // fiss or fill inventory.
+        std::stringstream ss;
+        ss << "prototype '" << prototype()
+           << "': Input stream weights/reactivity do not span "
+              "the requested material weight.";
+        cyclus::Warn<cyclus::VALUE_WARNING>(ss.str());
+      }
+      mix = mixes.insert(std::make_pair(tgt->id(), m1)).first;
     }
+
+    if (!mix->second) {
+      continue;
+    }
+
+    // requests of the same target and size share a single offer material
+    Material::Ptr& offer = offers[std::make_pair(tgt->id(), tgt_qty)];
+    if (!offer) {
+      offer = Material::CreateUntracked(mix->second->quantity() * tgt_qty,
+                                        mix->second->comp());
+    }
+    bool exclusive = false;
+    port->AddBid(req, offer, this, exclusive);
   }
 
-  cyclus::Converter<Material>::Ptr fissconv(
-      new FissConverter(c_fill, c_fiss, c_topup, spectrum));
-  cyclus::Converter<Material>::Ptr fillconv(
-      new FillConverter(c_fill, c_fiss, c_topup, spectrum));
-  cyclus::Converter<Material>::Ptr topupconv(
-      new TopupConverter(c_fill, c_fiss, c_topup, spectrum));
   // important! - the std::max calls prevent CapacityConstraint throwing a zero
   // cap exception
-  cyclus::CapacityConstraint<Material> fissc(std::max(fiss.quantity(), 1e-10),
-                                             fissconv);
-  cyclus::CapacityConstraint<Material> fillc(std::max(fill.quantity(), 1e-10),
-                                             fillconv);
-  cyclus::CapacityConstraint<Material> topupc(std::max(topup.quantity(), 1e-10),
-                                              topupconv);
-  port->AddConstraint(fillc);
-  port->AddConstraint(fissc);
-  port->AddConstraint(topupc);
+  cyclus::toolkit::ResBuf<Material>* bufs[N_STREAMS] = {&fill, &fiss, &topup};
+  for (int i = 0; i < N_STREAMS; i++) {
+    cyclus::Converter<Material>::Ptr conv(new StreamConverter(
+        comps, weights, use_topup, static_cast<Stream>(i), spec_));
+    cyclus::CapacityConstraint<Material> c(std::max(bufs[i]->quantity(), 1e-10),
+                                           conv);
+    port->AddConstraint(c);
+  }
 
   cyclus::CapacityConstraint<Material> cc(throughput);
   port->AddConstraint(cc);
@@ -390,29 +354,33 @@ void FuelFab::GetMatlTrades(
         responses) {
   using cyclus::Trade;
 
-  // guard against cases where a buffer is empty - this is okay because some 
-  // trades may not need that particular buffer.
-  double w_fill = 0;
-  if (fill.count() > 0) {
-    w_fill = CosiWeight(fill.Peek()->comp(), spectrum);
-  }
-  double w_topup = 0;
-  if (topup.count() > 0) {
-    w_topup = CosiWeight(topup.Peek()->comp(), spectrum);
-  }
-  double w_fiss = 0;
-  if (fiss.count() > 0) {
-    w_fiss = CosiWeight(fiss.Peek()->comp(), spectrum);
+  // guard against cases where a buffer is empty - this is okay because some
+  // trades may not need that particular buffer.  Empty buffers get a zero
+  // weight and no composition; the checks below never mix from them.
+  cyclus::toolkit::ResBuf<Material>* all[N_STREAMS] = {&fill, &fiss, &topup};
+  Composition::Ptr comps[N_STREAMS];
+  double weights[N_STREAMS] = {0, 0, 0};
+  for (int i = 0; i < N_STREAMS; i++) {
+    if (all[i]->count() > 0) {
+      comps[i] = all[i]->Peek()->comp();
+      weights[i] = CosiWeight(comps[i], spec_);
+    }
   }
-
-  std::vector<cyclus::Trade<cyclus::Material> >::const_iterator it;
+  double w_fill = weights[FILL];
+  double w_fiss = weights[FISS];
+
+  // Trades are grouped by target composition so the blend for each distinct
+  // target is only solved once.  blends maps a target composition id to the
+  // mass fraction drawn from each buffer in all.  Nothing is popped until
+  // every trade has been checked, and then each buffer is only split once for
+  // the summed draw of all trades.
+  std::map<int, std::vector<double> > blends;
+  std::vector<const std::vector<double>*> trade_fracs;
+  std::vector<double> draws(N_STREAMS, 0);
   double tot = 0;
   for (int i = 0; i < trades.size(); i++) {
-    Material::Ptr tgt = trades[i].request->target();
-
-    double w_tgt = CosiWeight(tgt->comp(), spectrum);
+    Composition::Ptr tgt = trades[i].request->target()->comp();
     double qty = trades[i].amt;
-    double wfiss = w_fiss;
 
     tot += qty;
     if (tot > throughput + cyclus::eps_rsrc()) {
@@ -422,74 +390,164 @@ void FuelFab::GetMatlTrades(
       throw cyclus::ValueError(ss.str());
     }
 
-    if (fiss.count() == 0) {
-      // use straight filler to satisfy this request
-      double fillqty = qty;
-      if (std::abs(fillqty - fill.quantity()) < cyclus::eps_rsrc()) {
-        fillqty = std::min(fill.quantity(), qty);
-      }
-      responses.push_back(
-          std::make_pair(trades[i], fill.Pop(fillqty, cyclus::eps_rsrc())));
-    } else if (fill.count() == 0 && ValidWeights(w_fill, w_tgt, w_fiss)) {
-      // use straight fissile to satisfy this request
-      double fissqty = qty;
-      if (std::abs(fissqty - fiss.quantity()) < cyclus::eps_rsrc()) {
-        fissqty = std::min(fiss.quantity(), qty);
-      }
-      responses.push_back(
-          std::make_pair(trades[i], fiss.Pop(fissqty, cyclus::eps_rsrc())));
-    } else if (ValidWeights(w_fill, w_tgt, w_fiss)) {
-      double fiss_frac = HighFrac(w_fill, w_tgt, w_fiss);
-      double fill_frac = LowFrac(w_fill, w_tgt, w_fiss);
-      fiss_frac =
-          AtomToMassFrac(fiss_frac, fiss.Peek()->comp(), fill.Peek()->comp());
-      fill_frac =
-          AtomToMassFrac(fill_frac, fill.Peek()->comp(), fiss.Peek()->comp());
-
-      double fissqty = fiss_frac * qty;
-      if (std::abs(fissqty - fiss.quantity()) < cyclus::eps_rsrc()) {
-        fissqty = std::min(fiss.quantity(), fiss_frac * qty);
-      }
-      double fillqty = fill_frac * qty;
-      if (std::abs(fillqty - fill.quantity()) < cyclus::eps_rsrc()) {
-        fillqty = std::min(fill.quantity(), fill_frac * qty);
+    std::map<int, std::vector<double> >::iterator blend =
+        blends.find(tgt->id());
+    if (blend == blends.end()) {
+      std::vector<double> f(N_STREAMS, 0);
+      double w_tgt = CosiWeight(tgt, spec_);
+      if (fiss.count() == 0) {
+        // use straight filler to satisfy this request
+        f[FILL] = 1;
+      } else if (fill.count() == 0 && ValidWeights(w_fill, w_tgt, w_fiss)) {
+        // use straight fissile to satisfy this request
+        f[FISS] = 1;
+      } else if (!MixFracs(comps, weights, w_tgt, topup.count() > 0, &f[0])) {
+        throw cyclus::ValueError("low and high weights cannot meet target");
       }
+      blend = blends.insert(std::make_pair(tgt->id(), f)).first;
+    }
 
-      Material::Ptr m = fiss.Pop(fissqty, cyclus::eps_rsrc());
-      // this if block prevents zero qty ResBuf pop exceptions
-      if (fill_frac > 0) {
-        m->Absorb(fill.Pop(fillqty, cyclus::eps_rsrc()));
+    trade_fracs.push_back(&blend->second);
+    for (int j = 0; j < N_STREAMS; j++) {
+      draws[j] += blend->second[j] * qty;
+    }
+  }
+
+  std::vector<Material::Ptr> mixed(trades.size());
+  for (int j = 0; j < N_STREAMS; j++) {
+    // skipping unused streams prevents zero qty ResBuf pop exceptions
+    if (draws[j] <= 0) {
+      continue;
+    }
+    cyclus::toolkit::ResBuf<Material>* buf = all[j];
+    double q = draws[j];
+    if (std::abs(q - buf->quantity()) < cyclus::eps_rsrc()) {
+      q = std::min(buf->quantity(), q);
+    }
+    Material::Ptr drawn = buf->Pop(q, cyclus::eps_rsrc());
+
+    // the last trade using this stream takes whatever is left so round-off
+    // never strands material in the drawn piece.
+    int last = 0;
+    for (int i = 0; i < trades.size(); i++) {
+      if ((*trade_fracs[i])[j] > 0) {
+        last = i;
       }
-      responses.push_back(std::make_pair(trades[i], m));
-    } else {
-      double topup_frac = HighFrac(w_fiss, w_tgt, w_topup);
-      double fiss_frac = 1 - topup_frac;
-      topup_frac =
-          AtomToMassFrac(topup_frac, topup.Peek()->comp(), fiss.Peek()->comp());
-      fiss_frac =
-          AtomToMassFrac(fiss_frac, fiss.Peek()->comp(), topup.Peek()->comp());
-
-      double fissqty = fiss_frac * qty;
-      if (std::abs(fissqty - fiss.quantity()) < cyclus::eps_rsrc()) {
-        fissqty = std::min(fiss.quantity(), fiss_frac * qty);
+    }
+    for (int i = 0; i <= last; i++) {
+      double f = (*trade_fracs[i])[j];
+      if (f <= 0) {
+        continue;
       }
-      double topupqty = topup_frac * qty;
-      if (std::abs(topupqty - topup.quantity()) < cyclus::eps_rsrc()) {
-        topupqty = std::min(topup.quantity(), topup_frac * qty);
+      Material::Ptr piece = drawn;
+      if (i != last) {
+        piece = drawn->ExtractQty(f * trades[i].amt);
       }
-
-      Material::Ptr m = fiss.Pop(fissqty, cyclus::eps_rsrc());
-      // this if block prevents zero qty ResBuf pop exceptions
-      if (topup_frac > 0) {
-        m->Absorb(topup.Pop(topupqty, cyclus::eps_rsrc()));
+      if (!mixed[i]) {
+        mixed[i] = piece;
+      } else {
+        mixed[i]->Absorb(piece);
       }
-      responses.push_back(std::make_pair(trades[i], m));
     }
   }
+
+  for (int i = 0; i < trades.size(); i++) {
+    responses.push_back(std::make_pair(trades[i], mixed[i]));
+  }
 }
 
-extern "C" cyclus::Agent* ConstructFuelFab(cyclus::Context* ctx) {
-  return new FuelFab(ctx);
+// One group cross section sets CosiWeight can use, indexed by Spectrum.  The
+// thermal set uses thermal nu values; every other set uses fast nu values.
+struct SpectrumInfo {
+  const char* name;
+  double nu_u233;
+  double nu_u235;
+  double nu_pu239;
+};
+
+static const SpectrumInfo kSpectra[N_SPECTRA] = {
+    {"thermal", 2.5, 2.43, 2.85},
+    {"thermal_maxwell_ave", 2.63, 2.58, 3.1},
+    {"fission_spectrum_ave", 2.63, 2.58, 3.1},
+    {"resonance_integral", 2.63, 2.58, 3.1},
+    {"fourteen_MeV", 2.63, 2.58, 3.1},
+};
+
+Spectrum ToSpectrum(const std::string& spectrum) {
+  for (int i = 0; i < N_SPECTRA; i++) {
+    if (spectrum == kSpectra[i].name) {
+      return static_cast<Spectrum>(i);
+    }
+  }
+  throw cyclus::ValueError("unsupported cross section spectrum '" + spectrum +
+                           "'");
+}
+
+// Returns nu*sigma_f - sigma_a for nuc.  Nuclides without cross section data
+// contribute nothing.
+static double Reactivity(int nuc, Spectrum spec) {
+  const SpectrumInfo& info = kSpectra[spec];
+  double nu = 0;
+  if (nuc == 922350000) {
+    nu = info.nu_u235;
+  } else if (nuc == 922330000) {
+    nu = info.nu_u233;
+  } else if (nuc == 942390000 || nuc == 942410000) {
+    nu = info.nu_pu239;
+  }
+
+  try {
+    double fiss = simple_xs(nuc, "fission", info.name);
+    double absorb = simple_xs(nuc, "absorption", info.name);
+    return nu * fiss - absorb;
+  } catch (pyne::InvalidSimpleXS err) {
+    return 0;
+  }
+}
+
+// Returns the weight of a single nuclide, (p_i - p_U238) / (p_Pu239 -
+// p_U238).  Results are cached per spectrum so cross sections are only looked
+// up once per nuclide.
+static double NucWeight(int nuc, Spectrum spec) {
+  static std::map<int, double> weights[N_SPECTRA];
+  static double p_u238[N_SPECTRA];
+  static double p_pu239[N_SPECTRA];
+  static bool init[N_SPECTRA] = {false};
+
+  std::map<int, double>& w = weights[spec];
+  std::map<int, double>::iterator found = w.find(nuc);
+  if (found != w.end()) {
+    return found->second;
+  }
+
+  if (!init[spec]) {
+    p_u238[spec] = Reactivity(922380000, spec);
+    p_pu239[spec] = Reactivity(942390000, spec);
+    init[spec] = true;
+  }
+
+  double p = Reactivity(nuc, spec);
+  double nw = (p - p_u238[spec]) / (p_pu239[spec] - p_u238[spec]);
+  w[nuc] = nw;
+  return nw;
+}
+
+// Returns the weight of c using 1 group cross sections of type spec.
+//
+// The weight is calculated as "(nu*sigma_f - sigma_a) * N".  Since weights
+// are computed based on nuclide atom fractions, corresponding computed
+// material/mixing fractions will also be atom-based naturally and will need
+// to be converted to mass-based for actual material object mixing.
+double CosiWeight(cyclus::Composition::Ptr c, Spectrum spec) {
+  const cyclus::CompMap& cm = c->atom();
+  cyclus::CompMap::const_iterator it;
+  double tot = 0;
+  double w = 0;
+  for (it = cm.begin(); it != cm.end(); ++it) {
+    tot += it->second;
+    w += it->second * NucWeight(it->first, spec);
+  }
+  return tot > 0 ? w / tot : 0;
 }
 
 // Returns the weight of c using 1 group cross sections of type spectrum
@@ -500,201 +558,51 @@ extern "C" cyclus::Agent* ConstructFuelFab(cyclus::Context* ctx) {
 //     * fission_spectrum_ave
 //     * resonance_integral
 //     * fourteen_MeV
-//
-// The weight is calculated as "(nu*sigma_f - sigma_a) * N".  Since weights
-// are computed based on nuclide atom fractions, corresponding computed
-// material/mixing fractions will also be atom-based naturally and will need
-// to be converted to mass-based for actual material object mixing.
 double CosiWeight(cyclus::Composition::Ptr c, const std::string& spectrum) {
-  cyclus::CompMap cm = c->atom();
-  cyclus::compmath::Normalize(&cm);
-
-  if (spectrum == "thermal") {
-    double nu_pu239 = 2.85;
-    double nu_u233 = 2.5;
-    double nu_u235 = 2.43;
-    double nu_u238 = 0;
-    double nu_pu241 = nu_pu239;
-
-    static std::map<int, double> absorb_xs;
-    static std::map<int, double> fiss_xs;
-    static double p_u238 = 0;
-    static double p_pu239 = 0;
-    if (p_u238 == 0) {
-      double fiss_u238 = simple_xs(922380000, "fission", "thermal");
-      double absorb_u238 = simple_xs(922380000, "absorption", "thermal");
-      p_u238 = nu_u238 * fiss_u238 - absorb_u238;
-
-      double fiss_pu239 = simple_xs(942390000, "fission", "thermal");
-      double absorb_pu239 = simple_xs(942390000, "absorption", "thermal");
-      p_pu239 = nu_pu239 * fiss_pu239 - absorb_pu239;
-    }
-
-    cyclus::CompMap::iterator it;
-    double w = 0;
-    for (it = cm.begin(); it != cm.end(); ++it) {
-      cyclus::Nuc nuc = it->first;
-      double nu = 0;
-      if (nuc == 922350000) {
-        nu = nu_u235;
-      } else if (nuc == 922330000) {
-        nu = nu_u233;
-      } else if (nuc == 942390000) {
-        nu = nu_pu239;
-      } else if (nuc == 942410000) {
-        nu = nu_pu241;
-      }
-
-      double fiss = 0;
-      double absorb = 0;
-      if (absorb_xs.count(nuc) == 0) {
-        try {
-          fiss = simple_xs(nuc, "fission", "thermal");
-          absorb = simple_xs(nuc, "absorption", "thermal");
-          absorb_xs[nuc] = absorb;
-          fiss_xs[nuc] = fiss;
-        } catch (pyne::InvalidSimpleXS err) {
-          fiss = 0;
-          absorb = 0;
-        }
-      } else {
-        fiss = fiss_xs[nuc];
-        absorb = absorb_xs[nuc];
-      }
-
-      double p = nu * fiss - absorb;
-      w += it->second * (p - p_u238) / (p_pu239 - p_u238);
-    }
-    return w;
-  } else if (spectrum == "fission_spectrum_ave") {
-    double nu_pu239 = 3.1;
-    double nu_u233 = 2.63;
-    double nu_u235 = 2.58;
-    double nu_u238 = 0;
-    double nu_pu241 = nu_pu239;
-
-    static std::map<int, double> absorb_xs;
-    static std::map<int, double> fiss_xs;
-    static double p_u238 = 0;
-    static double p_pu239 = 0;
-    if (p_u238 == 0) {
-      double fiss_u238 =
-          simple_xs(922380000, "fission", "fission_spectrum_ave");
-      double absorb_u238 =
-          simple_xs(922380000, "absorption", "fission_spectrum_ave");
-      p_u238 = nu_u238 * fiss_u238 - absorb_u238;
-
-      double fiss_pu239 =
-          simple_xs(942390000, "fission", "fission_spectrum_ave");
-      double absorb_pu239 =
-          simple_xs(942390000, "absorption", "fission_spectrum_ave");
-      p_pu239 = nu_pu239 * fiss_pu239 - absorb_pu239;
-    }
-
-    cyclus::CompMap::iterator it;
-    double w = 0;
-    for (it = cm.begin(); it != cm.end(); ++it) {
-      cyclus::Nuc nuc = it->first;
-      double nu = 0;
-      if (nuc == 922350000) {
-        nu = nu_u235;
-      } else if (nuc == 922330000) {
-        nu = nu_u233;
-      } else if (nuc == 942390000) {
-        nu = nu_pu239;
-      } else if (nuc == 942410000) {
-        nu = nu_pu241;
-      }
-
-      double fiss = 0;
-      double absorb = 0;
-      if (absorb_xs.count(nuc) == 0) {
-        try {
-          fiss = simple_xs(nuc, "fission", "fission_spectrum_ave");
-          absorb = simple_xs(nuc, "absorption", "fission_spectrum_ave");
-          absorb_xs[nuc] = absorb;
-          fiss_xs[nuc] = fiss;
-        } catch (pyne::InvalidSimpleXS err) {
-          fiss = 0;
-          absorb = 0;
-        }
-      } else {
-        fiss = fiss_xs[nuc];
-        absorb = absorb_xs[nuc];
-      }
+  return CosiWeight(c, ToSpectrum(spectrum));
+}
 
-      double p = nu * fiss - absorb;
-      w += it->second * (p - p_u238) / (p_pu239 - p_u238);
-    }
-    return w;
-  } else {
-    double nu_pu239 = 3.1;
-    double nu_u233 = 2.63;
-    double nu_u235 = 2.58;
-    double nu_u238 = 0;
-    double nu_pu241 = nu_pu239;
-
-    double fiss_u238 = simple_xs(922380000, "fission", spectrum);
-    double absorb_u238 = simple_xs(922380000, "absorption", spectrum);
-    double p_u238 = nu_u238 * fiss_u238 - absorb_u238;
-
-    double fiss_pu239 = simple_xs(942390000, "fission", spectrum);
-    double absorb_pu239 = simple_xs(942390000, "absorption", spectrum);
-    double p_pu239 = nu_pu239 * fiss_pu239 - absorb_pu239;
-
-    cyclus::CompMap::iterator it;
-    double w = 0;
-    for (it = cm.begin(); it != cm.end(); ++it) {
-      cyclus::Nuc nuc = it->first;
-      double nu = 0;
-      if (nuc == 922350000) {
-        nu = nu_u235;
-      } else if (nuc == 922330000) {
-        nu = nu_u233;
-      } else if (nuc == 942390000) {
-        nu = nu_pu239;
-      } else if (nuc == 942410000) {
-        nu = nu_pu241;
-      }
+extern "C" cyclus::Agent* ConstructFuelFab(cyclus::Context* ctx) {
+  return new FuelFab(ctx);
+}
 
-      double fiss = 0;
-      double absorb = 0;
-      try {
-        fiss = simple_xs(nuc, "fission", spectrum);
-        absorb = simple_xs(nuc, "absorption", spectrum);
-      } catch (pyne::InvalidSimpleXS err) {
-        fiss = 0;
-        absorb = 0;
-      }
+// maximum number of compositions MolarMass remembers.  Blends and decayed
+// materials keep minting new composition ids over a run, so the cache is
+// flushed when full rather than growing without bound.
+static const int kMaxMolarMasses = 100;
+
+// Returns the mean molar mass (mass per mole of atoms) of c.  Compositions are
+// immutable, so the result is cached by composition id and each composition
+// only pays for its pyne::atomic_mass lookups once.
+double MolarMass(Composition::Ptr c) {
+  static std::map<int, double> molar_masses;
+  std::map<int, double>::iterator found = molar_masses.find(c->id());
+  if (found != molar_masses.end()) {
+    return found->second;
+  }
 
-      double p = nu * fiss - absorb;
-      w += it->second * (p - p_u238) / (p_pu239 - p_u238);
-    }
-    return w;
+  const cyclus::CompMap& cm = c->atom();
+  cyclus::CompMap::const_iterator it;
+  double tot = 0;
+  double mass = 0;
+  for (it = cm.begin(); it != cm.end(); ++it) {
+    tot += it->second;
+    mass += it->second * pyne::atomic_mass(it->first);
+  }
+  double m = tot > 0 ? mass / tot : 0;
+  if (molar_masses.size() >= kMaxMolarMasses) {
+    molar_masses.clear();
   }
+  molar_masses[c->id()] = m;
+  return m;
 }
 
 // Convert an atom frac (n1/(n1+n2) to a mass frac (m1/(m1+m2) given
 // corresponding compositions c1 and c2.
 double AtomToMassFrac(double atomfrac, Composition::Ptr c1,
                       Composition::Ptr c2) {
-  cyclus::CompMap n1 = c1->atom();
-  cyclus::CompMap n2 = c2->atom();
-  cyclus::compmath::Normalize(&n1, atomfrac);
-  cyclus::compmath::Normalize(&n2, 1 - atomfrac);
-
-  cyclus::CompMap::iterator it;
-
-  double mass1 = 0;
-  for (it = n1.begin(); it != n1.end(); ++it) {
-    mass1 += it->second * pyne::atomic_mass(it->first);
-  }
-
-  double mass2 = 0;
-  for (it = n2.begin(); it != n2.end(); ++it) {
-    mass2 += it->second * pyne::atomic_mass(it->first);
-  }
-
+  double mass1 = atomfrac * MolarMass(c1);
+  double mass2 = (1 - atomfrac) * MolarMass(c2);
   return mass1 / (mass1 + mass2);
 }
 
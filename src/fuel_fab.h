@@ -7,6 +7,18 @@
 
 namespace cycamore {
 
+/// Spectrum identifies the PyNE one group cross section set used to compute
+/// stream weights.  The string form of each value is its lower case name
+/// (e.g. "fission_spectrum_ave"); see ToSpectrum.
+enum Spectrum {
+  THERMAL = 0,
+  THERMAL_MAXWELL_AVE,
+  FISSION_SPECTRUM_AVE,
+  RESONANCE_INTEGRAL,
+  FOURTEEN_MEV,
+  N_SPECTRA
+};
+
 /// FuelFab takes in 2 streams of material and mixes them in ratios in order to
 /// supply material that matches some neutronics properties of reqeusted
 /// material.  It uses an equivalence type method [1]
@@ -247,16 +259,24 @@ class FuelFab : public cyclus::Facility {
   }
   std::string spectrum;
 
+  // spectrum resolved once in EnterNotify - no need to be a state var
+  Spectrum spec_;
+
   // intra-time-step state - no need to be a state var
   // map<request, inventory name>
   std::map<cyclus::Request<cyclus::Material>*, std::string> req_inventories_;
 };
 
+Spectrum ToSpectrum(const std::string& spectrum);
+double CosiWeight(cyclus::Composition::Ptr c, Spectrum spec);
 double CosiWeight(cyclus::Composition::Ptr c, const std::string& spectrum);
 bool ValidWeights(double w_low, double w_tgt, double w_high);
 double LowFrac(double w_low, double w_tgt, double w_high, double eps = 1e-6);
 double HighFrac(double w_low, double w_tgt, double w_high, double eps = 1e-6);
 double AtomToMassFrac(double atomfrac, cyclus::Composition::Ptr c1, cyclus::Composition::Ptr c2);
+double MolarMass(cyclus::Composition::Ptr c);
+void Blend(cyclus::toolkit::ResBuf<cyclus::Material>* buf,
+           cyclus::Material::Ptr m);
 
 } // namespace cycamore
 
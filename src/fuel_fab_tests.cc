@@ -121,6 +121,49 @@ TEST(FuelFabTests, CosiWeight) {
   EXPECT_GT(w_therm, w_fast);
 }
 
+// Returns the reference weight of an equal atom mix of u235, u238 and pu239
+// computed straight from the PyNE cross sections with the given nu values.
+double RefWeight(const char* spec, double nu_u235, double nu_pu239) {
+  double p_u235 = nu_u235 * pyne::simple_xs(922350000, "fission", spec) -
+                  pyne::simple_xs(922350000, "absorption", spec);
+  double p_u238 = -pyne::simple_xs(922380000, "absorption", spec);
+  double p_pu239 = nu_pu239 * pyne::simple_xs(942390000, "fission", spec) -
+                   pyne::simple_xs(942390000, "absorption", spec);
+  // u238 and pu239 have weights 0 and 1 by definition
+  return ((p_u235 - p_u238) / (p_pu239 - p_u238) + 1) / 3;
+}
+
+TEST(FuelFabTests, CosiWeight_Spectrum) {
+  cyclus::Env::SetNucDataPath();
+  EXPECT_EQ(THERMAL, ToSpectrum("thermal"));
+  EXPECT_EQ(FISSION_SPECTRUM_AVE, ToSpectrum("fission_spectrum_ave"));
+  EXPECT_EQ(FOURTEEN_MEV, ToSpectrum("fourteen_MeV"));
+  EXPECT_THROW(ToSpectrum("bogus"), cyclus::ValueError);
+  EXPECT_THROW(CosiWeight(c_mox(), "bogus"), cyclus::ValueError);
+
+  CompMap mix;
+  mix[922350000] = 1;
+  mix[922380000] = 1;
+  mix[942390000] = 1;
+  Composition::Ptr c = Composition::CreateFromAtom(mix);
+
+  double w_therm = RefWeight("thermal", 2.43, 2.85);
+  double w_fast = RefWeight("fission_spectrum_ave", 2.58, 3.1);
+  EXPECT_NE(w_therm, w_fast);
+  EXPECT_NEAR(w_therm, CosiWeight(c, THERMAL), 1e-12);
+  EXPECT_NEAR(w_fast, CosiWeight(c, FISSION_SPECTRUM_AVE), 1e-12);
+  EXPECT_NEAR(RefWeight("fourteen_MeV", 2.58, 3.1),
+              CosiWeight(c, FOURTEEN_MEV), 1e-12);
+
+  // weights are atom fraction averaged so non-fissile nuclides dilute them
+  CompMap m;
+  m[942390000] = 1;
+  m[id("O16")] = 1;
+  double w_wet = CosiWeight(Composition::CreateFromAtom(m), THERMAL);
+  EXPECT_LT(w_wet, 1.0);
+  EXPECT_GT(w_wet, 0.0);
+}
+
 TEST(FuelFabTests, CosiWeight_Mixed) {
   cyclus::Env::SetNucDataPath();
   double w_fill = CosiWeight(c_natu(), "thermal");
@@ -183,6 +226,44 @@ TEST(FuelFabTests, ValidWeights) {
   EXPECT_EQ(false, ValidWeights(w_fill, w_fiss, w_target));
 }
 
+TEST(FuelFabTests, AtomToMassFrac) {
+  cyclus::Env::SetNucDataPath();
+  CompMap m;
+  m[922380000] = 1;
+  Composition::Ptr c = Composition::CreateFromAtom(m);
+  EXPECT_DOUBLE_EQ(pyne::atomic_mass(922380000), MolarMass(c));
+  // repeat lookups must hit the cache and give the same answer
+  EXPECT_DOUBLE_EQ(pyne::atomic_mass(922380000), MolarMass(c));
+
+  m.clear();
+  m[922380000] = 1;
+  m[942390000] = 3;
+  c = Composition::CreateFromAtom(m);
+  double want = (pyne::atomic_mass(922380000) +
+                 3 * pyne::atomic_mass(942390000)) / 4;
+  EXPECT_DOUBLE_EQ(want, MolarMass(c));
+
+  // compare against an explicit per-nuclide mass summation
+  double atomfrac = 0.3;
+  CompMap n1 = c_pustream()->atom();
+  CompMap n2 = c_natu()->atom();
+  cyclus::compmath::Normalize(&n1, atomfrac);
+  cyclus::compmath::Normalize(&n2, 1 - atomfrac);
+  double mass1 = 0;
+  double mass2 = 0;
+  CompMap::iterator it;
+  for (it = n1.begin(); it != n1.end(); ++it) {
+    mass1 += it->second * pyne::atomic_mass(it->first);
+  }
+  for (it = n2.begin(); it != n2.end(); ++it) {
+    mass2 += it->second * pyne::atomic_mass(it->first);
+  }
+  EXPECT_NEAR(mass1 / (mass1 + mass2),
+              AtomToMassFrac(atomfrac, c_pustream(), c_natu()), 1e-14);
+  EXPECT_DOUBLE_EQ(1.0, AtomToMassFrac(1, c_pustream(), c_natu()));
+  EXPECT_DOUBLE_EQ(0.0, AtomToMassFrac(0, c_pustream(), c_natu()));
+}
+
 // request (and receive) a specific recipe for fissile stream correctly.
 TEST(FuelFabTests, FissRecipe) {
   std::string config = 
@@ -540,6 +621,59 @@ TEST(FuelFabTests, CorrectMixing) {
   EXPECT_NEAR(0.25361268029, m->quantity(), 1e-6) << "mixed wrong amount of Pu stream";
 }
 
+// many requests for a few distinct target compositions are each met with
+// material matching their own target weight.
+TEST(FuelFabTests, GroupedTargets) {
+  std::string config =
+     "<fill_commods> <val>natu</val> </fill_commods>"
+     "<fill_recipe>natu</fill_recipe>"
+     "<fill_size>100</fill_size>"
+     ""
+     "<fiss_commods> <val>pustream</val> </fiss_commods>"
+     "<fiss_recipe>pustream</fiss_recipe>"
+     "<fiss_size>100</fiss_size>"
+     ""
+     "<outcommod>recyclefuel</outcommod>"
+     "<spectrum>thermal</spectrum>"
+     "<throughput>100</throughput>"
+     ;
+  int simdur = 3;
+  cyclus::MockSim sim(cyclus::AgentSpec(":cycamore:FuelFab"), config, simdur);
+  sim.AddSource("pustream").Finalize();
+  sim.AddSource("natu").Finalize();
+  for (int i = 0; i < 4; i++) {
+    sim.AddSink("recyclefuel").recipe("uox").capacity(5).lifetime(2).Finalize();
+  }
+  sim.AddSink("recyclefuel").recipe("mox").capacity(5).lifetime(2).Finalize();
+  sim.AddRecipe("uox", c_uox());
+  sim.AddRecipe("mox", c_mox());
+  sim.AddRecipe("pustream", c_pustream());
+  sim.AddRecipe("natu", c_natu());
+  int id = sim.Run();
+
+  std::vector<Cond> conds;
+  conds.push_back(Cond("Commodity", "==", std::string("recyclefuel")));
+  QueryResult qr = sim.db().Query("Transactions", &conds);
+  ASSERT_EQ(5, qr.rows.size());
+
+  double w_uox = CosiWeight(c_uox(), "thermal");
+  double w_mox = CosiWeight(c_mox(), "thermal");
+  int n_uox = 0;
+  int n_mox = 0;
+  for (int i = 0; i < qr.rows.size(); i++) {
+    Material::Ptr m = sim.GetMaterial(qr.GetVal<int>("ResourceId", i));
+    EXPECT_NEAR(5, m->quantity(), 1e-6);
+    double got = CosiWeight(m->comp(), "thermal");
+    if (std::abs((w_uox - got) / w_uox) < 0.00001) {
+      n_uox++;
+    } else if (std::abs((w_mox - got) / w_mox) < 0.00001) {
+      n_mox++;
+    }
+  }
+  EXPECT_EQ(4, n_uox) << "uox requests not met with uox weight material";
+  EXPECT_EQ(1, n_mox) << "mox request not met with mox weight material";
+}
+
 // fuel is requested requiring more filler than is available with plenty of
 // fissile.
 TEST(FuelFabTests, FillConstrained) {
@@ -845,6 +979,23 @@ TEST(FuelFabTests, SwapTopup_FissConstrained) {
   EXPECT_NEAR(max_provide, m->quantity(), 1e-10) << "matched trade uses more fiss than available";
 }
 
+TEST(FuelFabTests, BlendArrivals) {
+  // every trade accepted into a buffer is merged into its one resident
+  // material
+  cyclus::toolkit::ResBuf<Material> buf;
+  Blend(&buf, Material::CreateUntracked(3, c_natu()));
+  Blend(&buf, Material::CreateUntracked(2, c_uox()));
+  Blend(&buf, Material::CreateUntracked(5, c_natu()));
+  Blend(&buf, Material::CreateUntracked(1, c_mox()));
+
+  EXPECT_EQ(1, buf.count());
+  EXPECT_DOUBLE_EQ(11, buf.quantity());
+
+  MatQuery mq(buf.Peek());
+  double u235 = .007 * 8 + .04 * 2 + 1 * .7 / 104;
+  EXPECT_NEAR(u235, mq.mass(id("u235")), 1e-10);
+}
+
 // Before this test and a fix, the fuel fab (partially) assumed each entire material
 // buffer had the same composition as the material on top of the buffer when
 // calculating stream mixing ratios for material to supply.  This problem was
@@ -18,41 +18,47 @@ cyclus::Inventories Mixer::SnapshotInv() {
   invs["output-inv-name"] = output.PopNRes(output.count());
   output.Push(invs["output-inv-name"]);
 
-  std::map<std::string, cyclus::toolkit::ResBuf<cyclus::Material> >::iterator
-      it;
-  for (it = streambufs.begin(); it != streambufs.end(); ++it) {
-    invs[it->first] = it->second.PopNRes(it->second.count());
-    it->second.Push(invs[it->first]);
+  for (int i = 0; i < streambufs.size(); i++) {
+    std::string name = StreamName_(i);
+    invs[name] = streambufs[i].PopNRes(streambufs[i].count());
+    streambufs[i].Push(invs[name]);
   }
   return invs;
 }
 
 void Mixer::InitInv(cyclus::Inventories& inv) {
-  inv["output-inv-name"] = output.PopNRes(output.count());
   output.Push(inv["output-inv-name"]);
 
-  cyclus::Inventories::iterator it;
-  for (it = inv.begin(); it != inv.end(); ++it) {
-    streambufs[it->first].Push(it->second);
+  streambufs.resize(streams_.size());
+  for (int i = 0; i < streambufs.size(); i++) {
+    cyclus::Inventories::iterator it = inv.find(StreamName_(i));
+    if (it != inv.end()) {
+      streambufs[i].Push(it->second);
+    }
   }
 }
 
+std::string Mixer::StreamName_(int i) {
+  return "in_stream_" + std::to_string(i);
+}
+
 void Mixer::EnterNotify() {
   cyclus::Facility::EnterNotify();
 
   mixing_ratios.clear();
   in_buf_sizes.clear();
   in_commods.clear();
+  blends_.clear();
 
   // initialisation internal variable
+  streambufs.resize(streams_.size());
   for (int i = 0; i < streams_.size(); i++) {
     mixing_ratios.push_back(streams_[i].first.first);
     in_buf_sizes.push_back(streams_[i].first.second);
 
-    std::string name = "in_stream_" + std::to_string(i);
     double cap = in_buf_sizes[i];
     if (cap >= 0) {
-      streambufs[name].capacity(cap);
+      streambufs[i].capacity(cap);
     }
     in_commods.push_back(streams_[i].second);
   }
@@ -94,31 +100,58 @@ void Mixer::Tick() {
     double tgt_qty = output.space();
 
     for (int i = 0; i < mixing_ratios.size(); i++) {
-      std::string name = "in_stream_" + std::to_string(i);
-      tgt_qty =
-          std::min(tgt_qty, streambufs[name].quantity() / mixing_ratios[i]);
+      tgt_qty = std::min(tgt_qty, streambufs[i].quantity() / mixing_ratios[i]);
     }
 
     tgt_qty = std::min(tgt_qty, throughput);
 
     if (tgt_qty > 0) {
-      cyclus::Material::Ptr m;
+      cyclus::toolkit::MatVec draws;
       for (int i = 0; i < mixing_ratios.size(); i++) {
-        std::string name = "in_stream_" + std::to_string(i);
         double pop_qty = mixing_ratios[i] * tgt_qty;
-        if (i == 0) {
-          m = streambufs[name].Pop(pop_qty, cyclus::eps_rsrc());
-        } else {
-          cyclus::Material::Ptr m_ =
-              streambufs[name].Pop(pop_qty, cyclus::eps_rsrc());
-          m->Absorb(m_);
-        }
+        draws.push_back(streambufs[i].Pop(pop_qty, cyclus::eps_rsrc()));
       }
-      output.Push(m);
+
+      // the output is made once with the remembered blend rather than by
+      // absorbing each draw in turn, so no intermediate compositions are
+      // created and steps drawing the same stream compositions share one
+      // output composition
+      double qty = 0;
+      for (int i = 0; i < draws.size(); i++) {
+        qty += draws[i]->quantity();
+      }
+      output.Push(cyclus::Material::Create(this, qty, Blend_(draws)));
     }
   }
 }
 
+// Bound on the number of distinct blends remembered by a Mixer.
+static const int kMaxBlends = 100;
+
+cyclus::Composition::Ptr Mixer::Blend_(const cyclus::toolkit::MatVec& draws) {
+  std::vector<int> key;
+  for (int i = 0; i < draws.size(); i++) {
+    key.push_back(draws[i]->comp()->id());
+  }
+  std::map<std::vector<int>, cyclus::Composition::Ptr>::iterator it =
+      blends_.find(key);
+  if (it != blends_.end()) {
+    return it->second;
+  }
+
+  cyclus::CompMap v;
+  for (int i = 0; i < draws.size(); i++) {
+    cyclus::CompMap c = draws[i]->comp()->mass();
+    cyclus::compmath::Normalize(&c, mixing_ratios[i]);
+    v = cyclus::compmath::Add(v, c);
+  }
+
+  if (blends_.size() >= kMaxBlends) {
+    blends_.clear();
+  }
+  return blends_[key] = cyclus::Composition::CreateFromMass(v);
+}
+
 std::set<cyclus::RequestPortfolio<cyclus::Material>::Ptr>
 Mixer::GetMatlRequests() {
   using cyclus::RequestPortfolio;
@@ -126,14 +159,12 @@ Mixer::GetMatlRequests() {
   std::set<RequestPortfolio<cyclus::Material>::Ptr> ports;
   
   for (int i = 0; i < in_commods.size(); i++) {
-    std::string name = "in_stream_" + std::to_string(i);
-    
-    if (streambufs[name].space() > cyclus::eps_rsrc()) {
+    if (streambufs[i].space() > cyclus::eps_rsrc()) {
       RequestPortfolio<cyclus::Material>::Ptr port(
           new RequestPortfolio<cyclus::Material>());
 
       cyclus::Material::Ptr m;
-      m = cyclus::NewBlankMaterial(streambufs[name].space());
+      m = cyclus::NewBlankMaterial(streambufs[i].space());
 
       std::vector<cyclus::Request<cyclus::Material>*> reqs;
       
@@ -142,7 +173,7 @@ Mixer::GetMatlRequests() {
         std::string commod = it->first;
         double pref = it->second;
         reqs.push_back(port->AddRequest(m, this, commod , pref, false));
-        req_inventories_[reqs.back()] = name;
+        req_inventories_[reqs.back()] = i;
       }
       port->AddMutualReqs(reqs);  
       ports.insert(port);
@@ -161,21 +192,12 @@ void Mixer::AcceptMatlTrades(
     cyclus::Request<cyclus::Material>* req = trade->first.request;
     cyclus::Material::Ptr m = trade->second;
 
-    std::string name = req_inventories_[req];
-    bool assigned = false;
-    std::map<std::string, cyclus::toolkit::ResBuf<cyclus::Material> >::iterator
-        it;
-
-    for (it = streambufs.begin(); it != streambufs.end(); it++) {
-      if (name == it->first) {
-        it->second.Push(m);
-        assigned = true;
-        break;
-      }
-    }
-    if (!assigned) {
+    std::map<cyclus::Request<cyclus::Material>*, int>::iterator it =
+        req_inventories_.find(req);
+    if (it == req_inventories_.end()) {
       throw cyclus::ValueError("cycamore::Mixer was overmatched on requests");
     }
+    streambufs[it->second].Push(m);
   }
 
   req_inventories_.clear();
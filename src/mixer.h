@@ -69,8 +69,21 @@ class Mixer : public cyclus::Facility {
   std::vector<double> mixing_ratios;
 
   // custom SnapshotInv and InitInv and EnterNotify are used to persist this
-  // state var.
-  std::map<std::string, cyclus::toolkit::ResBuf<cyclus::Material> > streambufs;
+  // state var.  Buffers are indexed by stream slot (streams_ order).
+  std::vector<cyclus::toolkit::ResBuf<cyclus::Material> > streambufs;
+
+  /// Returns the inventory name used for the stream in slot i.
+  std::string StreamName_(int i);
+
+  /// Returns the composition of draws, one per stream slot, mixed in
+  /// mixing_ratios.  Blends are remembered by the draw compositions, so
+  /// streams that keep the same compositions from step to step are only
+  /// blended once.
+  cyclus::Composition::Ptr Blend_(const cyclus::toolkit::MatVec& draws);
+
+  // blends computed by Blend_, keyed by draw composition ids - no need to be
+  // a state var
+  std::map<std::vector<int>, cyclus::Composition::Ptr> blends_;
 
 
 #pragma cyclus var {                                                 \
@@ -104,8 +117,8 @@ class Mixer : public cyclus::Facility {
   double throughput;
 
   // intra-time-step state - no need to be a state var
-  // map<request, inventory name>
-  std::map<cyclus::Request<cyclus::Material>*, std::string> req_inventories_;
+  // map<request, stream slot>
+  std::map<cyclus::Request<cyclus::Material>*, int> req_inventories_;
 
   //// A policy for sending material
   cyclus::toolkit::MatlSellPolicy sell_policy;
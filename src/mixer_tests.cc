@@ -145,9 +145,11 @@ class MixerTest : public ::testing::Test {
   }
 
   void SetInputInv(std::vector<cyclus::Material::Ptr> mat) {
+    if (mf_facility_->streambufs.size() < mat.size()) {
+      mf_facility_->streambufs.resize(mat.size());
+    }
     for (int i = 0; i < mat.size(); i++) {
-      std::string name = "in_stream_" + std::to_string(i);
-      mf_facility_->streambufs[name].Push(mat[i]);
+      mf_facility_->streambufs[i].Push(mat[i]);
     }
   }
 
@@ -165,7 +167,7 @@ class MixerTest : public ::testing::Test {
 
   InvBuffer* GetOutPutBuffer() { return &mf_facility_->output; }
 
-  std::map<std::string, InvBuffer> GetStreamBuffer() {
+  std::vector<InvBuffer> GetStreamBuffer() {
     return mf_facility_->streambufs;
   }
 };
@@ -297,13 +299,12 @@ TEST_F(MixerTest, Throughput) {
     cap.push_back(in_cap[i] - 0.5 * in_frac[i]);
   }
 
-  std::map<std::string, InvBuffer> streambuf = GetStreamBuffer();
+  std::vector<InvBuffer> streambuf = GetStreamBuffer();
 
   for (int i = 0; i < in_coms.size(); i++) {
-    std::string name = "in_stream_" + std::to_string(i);
     double buf_size = in_cap[i];
     double buf_ratio = in_frac[i];
-    double buf_inv = streambuf[name].quantity();
+    double buf_inv = streambuf[i].quantity();
 
     // checking that each input buf was reduce of the correct amount
     // (constrained by the throughput"
@@ -318,6 +319,70 @@ TEST_F(MixerTest, Throughput) {
          "correctly constrained by throughput.";
 }
 
+// Check that repeated blends of the same stream compositions share one
+// composition
+TEST_F(MixerTest, BlendReused) {
+  using cyclus::Material;
+
+  std::vector<double> in_frac_ = {0.80, 0.15, 0.05};
+  SetStream_ratio(in_frac_);
+  SetOutStream_capacity(50);
+  SetThroughput(0.5);
+
+  std::vector<Material::Ptr> mat;
+  mat.push_back(Material::CreateUntracked(in_cap[0], c_natu()));
+  mat.push_back(Material::CreateUntracked(in_cap[1], c_pustream()));
+  mat.push_back(Material::CreateUntracked(in_cap[2], c_uox()));
+  SetInputInv(mat);
+
+  mf_facility_->Tick();
+  mf_facility_->Tick();
+
+  InvBuffer* buffer = GetOutPutBuffer();
+  ASSERT_EQ(2, buffer->count());
+  Material::Ptr first = buffer->Pop();
+  Material::Ptr second = buffer->Pop();
+  EXPECT_DOUBLE_EQ(0.5, first->quantity());
+  EXPECT_DOUBLE_EQ(0.5, second->quantity());
+  EXPECT_EQ(first->comp()->id(), second->comp()->id());
+}
+
+// Check that inventories survive a snapshot and restore
+TEST_F(MixerTest, InventoryRoundTrip) {
+  using cyclus::Material;
+
+  std::vector<double> in_frac_ = {0.80, 0.15, 0.05};
+  SetStream_ratio(in_frac_);
+  SetOutStream_capacity(50);
+  SetThroughput(0.5);
+  mf_facility_->EnterNotify();
+
+  std::vector<Material::Ptr> mat;
+  mat.push_back(Material::CreateUntracked(in_cap[0], c_natu()));
+  mat.push_back(Material::CreateUntracked(in_cap[1], c_pustream()));
+  mat.push_back(Material::CreateUntracked(in_cap[2], c_uox()));
+  SetInputInv(mat);
+  mf_facility_->Tick();
+
+  cyclus::Inventories invs = mf_facility_->SnapshotInv();
+  Mixer* restored = dynamic_cast<Mixer*>(mf_facility_->Clone());
+  restored->InitInv(invs);
+  cyclus::Inventories restored_invs = restored->SnapshotInv();
+
+  ASSERT_EQ(invs.size(), restored_invs.size());
+  cyclus::Inventories::iterator it;
+  for (it = invs.begin(); it != invs.end(); ++it) {
+    ASSERT_EQ(1, restored_invs.count(it->first)) << it->first;
+    std::vector<cyclus::Resource::Ptr>& rs = restored_invs[it->first];
+    ASSERT_EQ(it->second.size(), rs.size()) << it->first;
+    for (int i = 0; i < rs.size(); i++) {
+      EXPECT_DOUBLE_EQ(it->second[i]->quantity(), rs[i]->quantity());
+    }
+  }
+  EXPECT_EQ(1, restored_invs["output-inv-name"].size());
+  delete restored;
+}
+
 // multiple input streams can be correctly requested and used as
 //  material inventory.
 TEST(MixerTests, MultipleFissStreams) {
@@ -379,6 +379,8 @@ void Reactor::Transmute(int n_assem) {
 
 std::map<std::string, MatVec> Reactor::PeekSpent() {
   std::map<std::string, MatVec> mapped;
+  // ResBuf has no const iteration, so peek by copying the buffer out and
+  // pushing it straight back.
   MatVec mats = spent.PopN(spent.count());
   spent.Push(mats);
   for (int i = 0; i < mats.size(); i++) {
@@ -15,6 +15,7 @@ Separations::Separations(cyclus::Context* ctx) : cyclus::Facility(ctx) {}
 
 cyclus::Inventories Separations::SnapshotInv() {
   cyclus::Inventories invs;
+  InitSlots_();
 
   // these inventory names are intentionally convoluted so as to not clash
   // with the user-specified stream commods that are used as the separations
@@ -24,22 +25,24 @@ cyclus::Inventories Separations::SnapshotInv() {
   invs["feed-inv-name"] = feed.PopNRes(feed.count());
   feed.Push(invs["feed-inv-name"]);
 
-  std::map<std::string, ResBuf<Material> >::iterator it;
-  for (it = streambufs.begin(); it != streambufs.end(); ++it) {
-    invs[it->first] = it->second.PopNRes(it->second.count());
-    it->second.Push(invs[it->first]);
+  for (int i = 0; i < streambufs.size(); i++) {
+    invs[stream_names_[i]] = streambufs[i].PopNRes(streambufs[i].count());
+    streambufs[i].Push(invs[stream_names_[i]]);
   }
 
   return invs;
 }
 
 void Separations::InitInv(cyclus::Inventories& inv) {
+  InitSlots_();
   leftover.Push(inv["leftover-inv-name"]);
   feed.Push(inv["feed-inv-name"]);
 
-  cyclus::Inventories::iterator it;
-  for (it = inv.begin(); it != inv.end(); ++it) {
-    streambufs[it->first].Push(it->second);
+  for (int i = 0; i < streambufs.size(); i++) {
+    cyclus::Inventories::iterator it = inv.find(stream_names_[i]);
+    if (it != inv.end()) {
+      streambufs[i].Push(it->second);
+    }
   }
 }
 
@@ -53,14 +56,9 @@ void Separations::EnterNotify() {
   StreamSet::iterator it;
   std::map<int, double>::iterator it2;
 
+  InitSlots_();
   for (it = streams_.begin(); it != streams_.end(); ++it) {
-    std::string name = it->first;
     Stream stream = it->second;
-    double cap = stream.first;
-    if (cap >= 0) {
-      streambufs[name].capacity(cap);
-    }
-
     for (it2 = stream.second.begin(); it2 != stream.second.end(); it2++) {
       efficiency_[it2->first] += it2->second;
     }
@@ -95,57 +93,161 @@ void Separations::EnterNotify() {
       feed_commod_prefs.push_back(cyclus::kDefaultPref);
     }
   }
+
+  std::vector<std::map<int, double> > effs;
+  for (it = streams_.begin(); it != streams_.end(); ++it) {
+    effs.push_back(it->second.second);
+  }
+  std::vector<int> nucs;
+  if (!feed_recipe.empty()) {
+    const CompMap& cm = context()->GetRecipe(feed_recipe)->mass();
+    for (CompMap::const_iterator nuc = cm.begin(); nuc != cm.end(); ++nuc) {
+      nucs.push_back(nuc->first);
+    }
+  }
+  sep_table_.Init(effs, nucs);
+}
+
+void Separations::InitSlots_() {
+  if (!stream_slots_.empty()) {
+    return;
+  }
+
+  streambufs.resize(streams_.size());
+  StreamSet::iterator it;
+  for (it = streams_.begin(); it != streams_.end(); ++it) {
+    int slot = stream_names_.size();
+    stream_names_.push_back(it->first);
+    stream_slots_[it->first] = slot;
+    double cap = it->second.first;
+    if (cap >= 0) {
+      streambufs[slot].capacity(cap);
+    }
+  }
+  stream_slots_[leftover_commod] = streams_.size();
+}
+
+ResBuf<Material>* Separations::Buf_(int slot) {
+  if (slot < streambufs.size()) {
+    return &streambufs[slot];
+  }
+  return &leftover;
 }
 
 void Separations::Tick() {
   if (feed.count() == 0) {
     return;
+  } else if (!pipelined) {
+    double pop_qty = std::min(throughput, feed.quantity());
+    Material::Ptr rest = SepLot_(feed.Pop(pop_qty, cyclus::eps_rsrc()));
+    if (rest) {
+      ReturnFeed_(rest);
+    }
+    return;
+  }
+
+  // Work through the feed lots in order.  Each pop is limited up front to
+  // what the remaining throughput and stream buffer space allow for that
+  // lot's composition, so only the front lot is ever split and the rest of
+  // the feed inventory is never touched.
+  double remaining = throughput;
+  while (feed.count() > 0 && remaining > cyclus::eps_rsrc()) {
+    Material::Ptr lot = feed.Peek();
+    if (lot->quantity() < cyclus::eps_rsrc()) {
+      // round-off sized lots go straight to leftovers so they never block
+      // the queue, even when the stream buffers are full
+      leftover.Push(feed.Pop());
+      continue;
+    }
+
+    const SepSplit& split = sep_table_.Split(lot->comp());
+    double qty = std::min(remaining, lot->quantity());
+    for (int i = 0; i < streambufs.size(); i++) {
+      if (split.fracs[i] > 0) {
+        qty = std::min(qty, streambufs[i].space() / split.fracs[i]);
+      }
+    }
+    if (qty < cyclus::eps_rsrc()) {
+      break;  // stream buffers are full
+    }
+
+    Material::Ptr mat = feed.Pop(qty, cyclus::eps_rsrc());
+    remaining -= mat->quantity();
+    Material::Ptr rest = SepLot_(mat);
+    if (rest) {
+      // only round-off can leave part of the pop unprocessed, and it means
+      // the stream buffers are full
+      ReturnFeed_(rest);
+      break;
+    }
   }
-  double pop_qty = std::min(throughput, feed.quantity());
-  Material::Ptr mat = feed.Pop(pop_qty, cyclus::eps_rsrc());
+}
+
+void Separations::ReturnFeed_(Material::Ptr mat) {
+  // ResBuf only pushes to the back, so the waiting lots are queued up again
+  // behind mat.  This only happens once a stream buffer has filled up.
+  MatVec waiting = feed.PopN(feed.count());
+  feed.Push(mat);
+  feed.Push(waiting);
+}
+
+Material::Ptr Separations::SepLot_(Material::Ptr mat) {
   double orig_qty = mat->quantity();
 
-  StreamSet::iterator it;
+  // split the whole popped feed in one pass - stream and leftover
+  // compositions are looked up once per feed composition and applied to
+  // plain quantity extractions rather than re-normalizing the feed once per
+  // stream.
+  const SepSplit& split = sep_table_.Split(mat->comp());
+  std::vector<double> qtys(split.fracs);
+  for (int j = 0; j < qtys.size(); j++) {
+    qtys[j] *= orig_qty;
+  }
+
   double maxfrac = 1;
-  std::map<std::string, Material::Ptr> stagedsep;
-  for (it = streams_.begin(); it != streams_.end(); ++it) {
-    Stream info = it->second;
-    std::string name = it->first;
-    stagedsep[name] = SepMaterial(info.second, mat);
-    double frac = streambufs[name].space() / stagedsep[name]->quantity();
+  for (int i = 0; i < streambufs.size(); i++) {
+    if (qtys[i] <= 0) {
+      continue;
+    }
+    double frac = streambufs[i].space() / qtys[i];
     if (frac < maxfrac) {
       maxfrac = frac;
     }
   }
 
-  std::map<std::string, Material::Ptr>::iterator itf;
-  for (itf = stagedsep.begin(); itf != stagedsep.end(); ++itf) {
-    std::string name = itf->first;
-    Material::Ptr m = itf->second;
-    if (m->quantity() > 0) {
-      streambufs[name].Push(
-          mat->ExtractComp(m->quantity() * maxfrac, m->comp()));
-    }
+  Material::Ptr rest;
+  if (maxfrac <= 0) {
+    // no room in at least one stream - nothing can be processed
+    return mat;
+  } else if (maxfrac < 1) {
+    // hand back any unprocessed feed due to separated stream inv size
+    // constraints.  It is split off before separating so it keeps the feed
+    // composition.
+    rest = mat->ExtractQty((1 - maxfrac) * orig_qty);
   }
 
-  if (maxfrac == 1) {
-    if (mat->quantity() > 0) {
-      // unspecified separations fractions go to leftovers
-      leftover.Push(mat);
+  for (int i = 0; i < streambufs.size(); i++) {
+    if (qtys[i] > 0) {
+      Material::Ptr m = mat->ExtractQty(qtys[i] * maxfrac);
+      m->Transmute(split.comps[i]);
+      streambufs[i].Push(m);
     }
-  } else {  // maxfrac is < 1
-    // push back any leftover feed due to separated stream inv size constraints
-    feed.Push(mat->ExtractQty((1 - maxfrac) * orig_qty));
-    if (mat->quantity() > 0) {
-      // unspecified separations fractions go to leftovers
-      leftover.Push(mat);
+  }
+
+  if (mat->quantity() > 0) {
+    // unspecified separations fractions go to leftovers
+    if (split.left) {
+      mat->Transmute(split.left);
     }
+    leftover.Push(mat);
   }
+  return rest;
 }
 
 // Note that this returns an untracked material that should just be used for
 // its composition and qty - not in any real inventories, etc.
-Material::Ptr SepMaterial(std::map<int, double> effs, Material::Ptr mat) {
+Material::Ptr SepMaterial(const std::map<int, double>& effs,
+                          Material::Ptr mat) {
   CompMap cm = mat->comp()->mass();
   cyclus::compmath::Normalize(&cm, mat->quantity());
   double tot_qty = 0;
@@ -155,17 +257,16 @@ Material::Ptr SepMaterial(std::map<int, double> effs, Material::Ptr mat) {
   for (it = cm.begin(); it != cm.end(); ++it) {
     int nuc = it->first;
     int elem = (nuc / 10000000) * 10000000;
-    double eff = 0;
-    if (effs.count(nuc) > 0) {
-      eff = effs[nuc];
-    } else if (effs.count(elem) > 0) {
-      eff = effs[elem];
-    } else {
+    std::map<int, double>::const_iterator eff = effs.find(nuc);
+    if (eff == effs.end()) {
+      eff = effs.find(elem);
+    }
+    if (eff == effs.end()) {
       continue;
     }
 
     double qty = it->second;
-    double sepqty = qty * eff;
+    double sepqty = qty * eff->second;
     sepcomp[nuc] = sepqty;
     tot_qty += sepqty;
   }
@@ -174,6 +275,137 @@ Material::Ptr SepMaterial(std::map<int, double> effs, Material::Ptr mat) {
   return Material::CreateUntracked(tot_qty, c);
 };
 
+// Upper bound on the number of feed compositions whose splits and row indices
+// are kept by a SepTable.  Feeds that keep changing (e.g. decaying) would
+// otherwise grow the caches without bound.
+static const int kMaxSplits = 100;
+
+void SepTable::Init(const std::vector<std::map<int, double> >& effs,
+                    const std::vector<int>& nucs) {
+  effs_ = effs;
+  rows_.clear();
+  comp_rows_.clear();
+  table_.clear();
+  splits_.clear();
+  for (int i = 0; i < nucs.size(); i++) {
+    Row(nucs[i]);
+  }
+}
+
+int SepTable::Row(int nuc) {
+  std::map<int, int>::iterator found = rows_.find(nuc);
+  if (found != rows_.end()) {
+    return found->second;
+  }
+
+  // nuclide efficiencies take precedence over their element's
+  int n = nstreams();
+  int elem = (nuc / 10000000) * 10000000;
+  int row = rows_.size();
+  rows_[nuc] = row;
+  table_.resize((row + 1) * n, 0);
+  for (int s = 0; s < n; s++) {
+    std::map<int, double>::const_iterator eff = effs_[s].find(nuc);
+    if (eff == effs_[s].end()) {
+      eff = effs_[s].find(elem);
+    }
+    if (eff != effs_[s].end()) {
+      table_[row * n + s] = eff->second;
+    }
+  }
+  return row;
+}
+
+const std::vector<int>& SepTable::CompRows(Composition::Ptr c) {
+  std::map<int, std::vector<int> >::iterator found = comp_rows_.find(c->id());
+  if (found != comp_rows_.end()) {
+    return found->second;
+  }
+
+  if (comp_rows_.size() >= kMaxSplits) {
+    comp_rows_.clear();
+  }
+
+  const CompMap& cm = c->mass();
+  std::vector<int>& rows = comp_rows_[c->id()];
+  rows.reserve(cm.size());
+  CompMap::const_iterator it;
+  for (it = cm.begin(); it != cm.end(); ++it) {
+    rows.push_back(Row(it->first));
+  }
+  return rows;
+}
+
+void SepTable::Separate(Material::Ptr mat, std::vector<CompMap>* seps,
+                        std::vector<double>* qtys, CompMap* left) {
+  int n = nstreams();
+  seps->assign(n, CompMap());
+  qtys->assign(n, 0);
+  if (left != NULL) {
+    left->clear();
+  }
+
+  const CompMap& cm = mat->comp()->mass();
+  double tot = 0;
+  CompMap::const_iterator it;
+  for (it = cm.begin(); it != cm.end(); ++it) {
+    tot += it->second;
+  }
+  if (tot <= 0) {
+    return;
+  }
+
+  // all rows are resolved up front so table_ doesn't move during the walk
+  const std::vector<int>& rows = CompRows(mat->comp());
+  double scale = mat->quantity() / tot;
+  int k = 0;
+  for (it = cm.begin(); it != cm.end(); ++it, ++k) {
+    double qty = it->second * scale;
+    double sepqty_tot = 0;
+    const double* row = n > 0 ? &table_[rows[k] * n] : NULL;
+    for (int s = 0; s < n; s++) {
+      if (row[s] > 0) {
+        double sepqty = qty * row[s];
+        (*seps)[s][it->first] = sepqty;
+        (*qtys)[s] += sepqty;
+        sepqty_tot += sepqty;
+      }
+    }
+    if (left != NULL && qty - sepqty_tot > 0) {
+      (*left)[it->first] = qty - sepqty_tot;
+    }
+  }
+}
+
+const SepSplit& SepTable::Split(Composition::Ptr feed) {
+  std::map<int, SepSplit>::iterator found = splits_.find(feed->id());
+  if (found != splits_.end()) {
+    return found->second;
+  }
+
+  if (splits_.size() >= kMaxSplits) {
+    splits_.clear();
+  }
+
+  std::vector<CompMap> seps;
+  std::vector<double> qtys;
+  CompMap left;
+  Separate(Material::CreateUntracked(1, feed), &seps, &qtys, &left);
+
+  SepSplit& split = splits_[feed->id()];
+  split.fracs = qtys;
+  split.comps.resize(seps.size());
+  for (int i = 0; i < seps.size(); i++) {
+    if (!seps[i].empty()) {
+      split.comps[i] = Composition::CreateFromMass(seps[i]);
+    }
+  }
+  if (!left.empty()) {
+    split.left = Composition::CreateFromMass(left);
+  }
+  return split;
+}
+
 std::set<cyclus::RequestPortfolio<Material>::Ptr>
 Separations::GetMatlRequests() {
   using cyclus::RequestPortfolio;
@@ -214,21 +446,17 @@ void Separations::GetMatlTrades(
         responses) {
   using cyclus::Trade;
 
-  std::vector<cyclus::Trade<cyclus::Material> >::const_iterator it;
   for (int i = 0; i < trades.size(); i++) {
     std::string commod = trades[i].request->commodity();
-    if (commod == leftover_commod) {
-      double amt = std::min(leftover.quantity(), trades[i].amt);
-      Material::Ptr m = leftover.Pop(amt, cyclus::eps_rsrc());
-      responses.push_back(std::make_pair(trades[i], m));
-    } else if (streambufs.count(commod) > 0) {
-      double amt = std::min(streambufs[commod].quantity(), trades[i].amt);
-      Material::Ptr m = streambufs[commod].Pop(amt, cyclus::eps_rsrc());
-      responses.push_back(std::make_pair(trades[i], m));
-    } else {
+    std::map<std::string, int>::iterator slot = stream_slots_.find(commod);
+    if (slot == stream_slots_.end()) {
       throw ValueError("invalid commodity " + commod +
                        " on trade matched to prototype " + prototype());
     }
+    ResBuf<Material>* buf = Buf_(slot->second);
+    double amt = std::min(buf->quantity(), trades[i].amt);
+    Material::Ptr m = buf->Pop(amt, cyclus::eps_rsrc());
+    responses.push_back(std::make_pair(trades[i], m));
   }
 }
 
@@ -250,61 +478,37 @@ std::set<cyclus::BidPortfolio<Material>::Ptr> Separations::GetMatlBids(
   bool exclusive = false;
   std::set<BidPortfolio<Material>::Ptr> ports;
 
-  // bid streams
-  std::map<std::string, ResBuf<Material> >::iterator it;
-  for (it = streambufs.begin(); it != streambufs.end(); ++it) {
-    std::string commod = it->first;
+  // bid streams and then leftovers
+  for (int slot = 0; slot <= streambufs.size(); slot++) {
+    std::string commod = leftover_commod;
+    if (slot < streambufs.size()) {
+      commod = stream_names_[slot];
+    }
+    ResBuf<Material>* buf = Buf_(slot);
     std::vector<Request<Material>*>& reqs = commod_requests[commod];
     if (reqs.size() == 0) {
       continue;
-    } else if (streambufs[commod].quantity() < cyclus::eps_rsrc()) {
+    } else if (buf->quantity() < cyclus::eps_rsrc()) {
       continue;
     }
 
-    MatVec mats = streambufs[commod].PopN(streambufs[commod].count());
-    streambufs[commod].Push(mats);
-
     BidPortfolio<Material>::Ptr port(new BidPortfolio<Material>());
 
-    for (int j = 0; j < reqs.size(); j++) {
-      Request<Material>* req = reqs[j];
-      double tot_bid = 0;
-      for (int k = 0; k < mats.size(); k++) {
-        Material::Ptr m = mats[k];
-        tot_bid += m->quantity();
-
-        // this fix the problem of the cyclus exchange manager which crashes
-        // when a bid with a quantity <=0 is offered.
-        if (m->quantity() > cyclus::eps_rsrc()) {
-          port->AddBid(req, m, this, exclusive);
-        }
-
-        if (tot_bid >= req->target()->quantity()) {
-          break;
+    MatVec mats = buf->PopN(buf->count());
+    buf->Push(mats);
+
+    // each request is offered materials oldest first until their total
+    // covers the request - done for all requests in one pass over the buffer.
+    std::vector<double> tot_bid(reqs.size(), 0);
+    int nopen = reqs.size();
+    for (int k = 0; k < mats.size() && nopen > 0; k++) {
+      Material::Ptr m = mats[k];
+      for (int j = 0; j < reqs.size(); j++) {
+        Request<Material>* req = reqs[j];
+        if (tot_bid[j] >= req->target()->quantity()) {
+          continue;
         }
-      }
-    }
-
-    double tot_qty = streambufs[commod].quantity();
-    cyclus::CapacityConstraint<Material> cc(tot_qty);
-    port->AddConstraint(cc);
-    ports.insert(port);
-  }
-
-  // bid leftovers
-  std::vector<Request<Material>*>& reqs = commod_requests[leftover_commod];
-  if (reqs.size() > 0 && leftover.quantity() >= cyclus::eps_rsrc()) {
-    MatVec mats = leftover.PopN(leftover.count());
-    leftover.Push(mats);
-
-    BidPortfolio<Material>::Ptr port(new BidPortfolio<Material>());
-
-    for (int j = 0; j < reqs.size(); j++) {
-      Request<Material>* req = reqs[j];
-      double tot_bid = 0;
-      for (int k = 0; k < mats.size(); k++) {
-        Material::Ptr m = mats[k];
-        tot_bid += m->quantity();
+        tot_bid[j] += m->quantity();
 
         // this fix the problem of the cyclus exchange manager which crashes
         // when a bid with a quantity <=0 is offered.
@@ -312,13 +516,13 @@ std::set<cyclus::BidPortfolio<Material>::Ptr> Separations::GetMatlBids(
           port->AddBid(req, m, this, exclusive);
         }
 
-        if (tot_bid >= req->target()->quantity()) {
-          break;
+        if (tot_bid[j] >= req->target()->quantity()) {
+          nopen--;
         }
       }
     }
 
-    cyclus::CapacityConstraint<Material> cc(leftover.quantity());
+    cyclus::CapacityConstraint<Material> cc(buf->quantity());
     port->AddConstraint(cc);
     ports.insert(port);
   }
@@ -333,9 +537,8 @@ bool Separations::CheckDecommissionCondition() {
     return false;
   }
 
-  std::map<std::string, ResBuf<Material> >::iterator it;
-  for (it = streambufs.begin(); it != streambufs.end(); ++it) {
-    if (it->second.count() > 0) {
+  for (int i = 0; i < streambufs.size(); i++) {
+    if (streambufs[i].count() > 0) {
       return false;
     }
   }
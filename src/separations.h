@@ -13,9 +13,73 @@ namespace cycamore {
 /// separations efficiency for that nuclide or element.  Note that this returns
 /// an untracked material that should only be used for its composition and qty
 /// - not in any real inventories, etc.
-cyclus::Material::Ptr SepMaterial(std::map<int, double> effs,
+cyclus::Material::Ptr SepMaterial(const std::map<int, double>& effs,
                                   cyclus::Material::Ptr mat);
 
+/// SepSplit describes how a unit mass of one feed composition is split by a
+/// SepTable.
+struct SepSplit {
+  /// mass separated into each stream per unit mass of feed
+  std::vector<double> fracs;
+  /// composition of each stream's separated material (null if empty)
+  std::vector<cyclus::Composition::Ptr> comps;
+  /// composition of the material not separated into any stream (null if
+  /// empty)
+  cyclus::Composition::Ptr left;
+};
+
+/// SepTable holds the separations efficiencies of several streams compiled
+/// into a dense table with one row per nuclide and one column per stream.
+/// Element efficiencies are expanded onto each nuclide (with nuclide entries
+/// taking precedence) the first time that nuclide is seen.  The rows used by a
+/// feed composition are resolved once per composition, so splitting a feed
+/// material into every stream is a walk over a flat vector of row indices
+/// with one multiply per stream for each nuclide in the feed.
+class SepTable {
+ public:
+  SepTable() {}
+
+  /// Replaces the table contents with the given per-stream efficiencies (same
+  /// key conventions as SepMaterial).  The optional nucs are expanded into
+  /// rows immediately rather than on first use.
+  void Init(const std::vector<std::map<int, double> >& effs,
+            const std::vector<int>& nucs = std::vector<int>());
+
+  /// Returns the number of streams in the table.
+  int nstreams() const { return effs_.size(); }
+
+  /// Computes the mass of each nuclide from mat separated into every stream.
+  /// On return seps[i] holds the separated nuclide masses for stream i and
+  /// qtys[i] their total.  If left is given, it receives the nuclide masses
+  /// not separated into any stream.
+  void Separate(cyclus::Material::Ptr mat, std::vector<cyclus::CompMap>* seps,
+                std::vector<double>* qtys, cyclus::CompMap* left = NULL);
+
+  /// Returns the split of the given feed composition.  Splits are interned
+  /// by feed composition so separating the same feed again reuses the same
+  /// stream Composition objects (and their output rows) instead of creating
+  /// new ones.
+  const SepSplit& Split(cyclus::Composition::Ptr feed);
+
+ private:
+  /// Returns the table row index for nuc, adding the row if needed.
+  int Row(int nuc);
+
+  /// Returns the table row index of each nuclide of c, in the order of its
+  /// mass CompMap.
+  const std::vector<int>& CompRows(cyclus::Composition::Ptr c);
+
+  std::vector<std::map<int, double> > effs_;
+  /// map<nuclide, row index>
+  std::map<int, int> rows_;
+  /// map<composition id, row index of each nuclide>
+  std::map<int, std::vector<int> > comp_rows_;
+  /// row-major efficiencies, i.e. table_[row * nstreams() + stream]
+  std::vector<double> table_;
+  /// map<feed composition id, split>
+  std::map<int, SepSplit> splits_;
+};
+
 /// Separations processes feed material into one or more streams containing
 /// specific elements and/or nuclides.  It uses mass-based efficiencies.
 ///
@@ -152,6 +216,17 @@ class Separations : public cyclus::Facility {
   }
   double throughput;
 
+  #pragma cyclus var { \
+    "default": False, \
+    "doc": "If true, feed is processed as a first-in-first-out queue of lots" \
+           " that are each separated with their own composition, and a lot" \
+           " only partially processed in one time step is continued in the" \
+           " next.  Otherwise all the feed processed in a time step is" \
+           " combined into a single material before separation.", \
+    "uilabel": "Pipelined Feed Processing", \
+  }
+  bool pipelined;
+
   #pragma cyclus var { \
     "doc": "Commodity on which to trade the leftover separated material " \
            "stream. This MUST NOT be the same as any commodity used to define "\
@@ -200,9 +275,36 @@ class Separations : public cyclus::Facility {
   }
   std::map<std::string, std::pair<double, std::map<int, double> > > streams_;
 
+  /// Resolves the stream commodities into dense slots (streams_ order) and
+  /// sizes streambufs to match.  Safe to call more than once.
+  void InitSlots_();
+
+  /// Separates mat into the stream and leftover buffers.  Returns the part of
+  /// mat that doesn't fit in the stream buffers (with the feed composition),
+  /// or a null pointer if all of mat was processed.
+  cyclus::Material::Ptr SepLot_(cyclus::Material::Ptr mat);
+
+  /// Puts unprocessed feed back at the front of the feed buffer so it is the
+  /// next lot processed.
+  void ReturnFeed_(cyclus::Material::Ptr mat);
+
+  /// Returns the buffer for slot - the slot after the last stream is the
+  /// leftover buffer.
+  cyclus::toolkit::ResBuf<cyclus::Material>* Buf_(int slot);
+
   // custom SnapshotInv and InitInv and EnterNotify are used to persist this
-  // state var.
-  std::map<std::string, cyclus::toolkit::ResBuf<cyclus::Material> > streambufs;
+  // state var.  Buffers are indexed by stream slot.
+  std::vector<cyclus::toolkit::ResBuf<cyclus::Material> > streambufs;
+
+  // built by InitSlots_ - no need to be state vars.  stream_names_ holds the
+  // commodity of each stream slot and stream_slots_ maps every commodity
+  // traded (including leftover_commod) to its slot.
+  std::vector<std::string> stream_names_;
+  std::map<std::string, int> stream_slots_;
+
+  // stream efficiencies compiled in EnterNotify - no need to be a state var.
+  // Columns are in streams_ order.
+  SepTable sep_table_;
 };
 
 }  // namespace cycamore
@@ -1,6 +1,7 @@
 #include "separations.h"
 
 #include <gtest/gtest.h>
+#include <ctime>
 #include <sstream>
 #include "cyclus.h"
 
@@ -43,6 +44,108 @@ TEST(SeparationsTests, SepMaterial) {
   EXPECT_DOUBLE_EQ(0, mqsep.mass("Am242"));
 }
 
+// a SepTable must split a feed into every stream exactly as SepMaterial does
+// for each stream on its own - checked on a large spent-fuel-like feed.
+TEST(SeparationsTests, SepTable) {
+  int nstreams = 10;
+  CompMap comp;
+  for (int z = 1; z <= 100; z++) {
+    for (int a = 2 * z; a < 2 * z + 15; a++) {
+      comp[(z * 1000 + a) * 10000] = 1.0 / (z + a);
+    }
+  }
+  ASSERT_EQ(1500, comp.size());
+  double qty = 1000;
+  Material::Ptr mat =
+      Material::CreateUntracked(qty, Composition::CreateFromMass(comp));
+
+  // each stream separates a tenth of the elements with a few nuclide-specific
+  // overrides mixed in to exercise the element fallback.
+  std::vector<std::map<int, double> > effs(nstreams);
+  for (int z = 1; z <= 100; z++) {
+    std::map<int, double>& e = effs[z % nstreams];
+    e[z * 10000000] = 0.5 + 0.004 * z;
+    if (z % 3 == 0) {
+      e[(z * 1000 + 2 * z + 1) * 10000] = 0.1;
+    }
+  }
+
+  SepTable table;
+  table.Init(effs);
+  ASSERT_EQ(nstreams, table.nstreams());
+
+  std::vector<CompMap> seps;
+  std::vector<double> qtys;
+  table.Separate(mat, &seps, &qtys);
+  ASSERT_EQ(nstreams, seps.size());
+  ASSERT_EQ(nstreams, qtys.size());
+
+  for (int s = 0; s < nstreams; s++) {
+    Material::Ptr want = SepMaterial(effs[s], mat);
+    EXPECT_NEAR(want->quantity(), qtys[s], 1e-9 * qty) << "stream " << s;
+
+    CompMap wantcm = want->comp()->mass();
+    cyclus::compmath::Normalize(&wantcm, want->quantity());
+    EXPECT_EQ(wantcm.size(), seps[s].size()) << "stream " << s;
+    CompMap::iterator it;
+    for (it = wantcm.begin(); it != wantcm.end(); ++it) {
+      EXPECT_NEAR(it->second, seps[s][it->first], 1e-9 * qty)
+          << "stream " << s << " nuclide " << it->first;
+    }
+  }
+
+  // repeat separations reuse the compiled rows and give the same answer
+  std::vector<double> again;
+  table.Separate(mat, &seps, &again);
+  for (int s = 0; s < nstreams; s++) {
+    EXPECT_DOUBLE_EQ(qtys[s], again[s]);
+  }
+}
+
+
+// Microbenchmark for splitting a 1,500 nuclide spent-fuel-like feed into 10
+// streams: per-stream SepMaterial calls against one compiled SepTable pass.
+// Disabled by default - run with --gtest_also_run_disabled_tests.
+TEST(SeparationsTests, DISABLED_SepTableBenchmark) {
+  int nstreams = 10;
+  int nreps = 200;
+  CompMap comp;
+  for (int z = 1; z <= 100; z++) {
+    for (int a = 2 * z; a < 2 * z + 15; a++) {
+      comp[(z * 1000 + a) * 10000] = 1.0 / (z + a);
+    }
+  }
+  Material::Ptr mat =
+      Material::CreateUntracked(1000, Composition::CreateFromMass(comp));
+
+  std::vector<std::map<int, double> > effs(nstreams);
+  for (int z = 1; z <= 100; z++) {
+    effs[z % nstreams][z * 10000000] = 0.5 + 0.004 * z;
+  }
+
+  std::clock_t start = std::clock();
+  for (int r = 0; r < nreps; r++) {
+    for (int s = 0; s < nstreams; s++) {
+      SepMaterial(effs[s], mat);
+    }
+  }
+  double t_sepmat = double(std::clock() - start) / CLOCKS_PER_SEC;
+
+  SepTable table;
+  table.Init(effs);
+  std::vector<CompMap> seps;
+  std::vector<double> qtys;
+  start = std::clock();
+  for (int r = 0; r < nreps; r++) {
+    table.Separate(mat, &seps, &qtys);
+  }
+  double t_table = double(std::clock() - start) / CLOCKS_PER_SEC;
+
+  std::cout << "SepMaterial x " << nstreams << ": "
+            << 1e3 * t_sepmat / nreps << " ms/feed\n"
+            << "SepTable::Separate: " << 1e3 * t_table / nreps
+            << " ms/feed\n";
+}
   
 // Check that cumulative separations efficiency for a single nuclide of less than or equal to one does not trigger an error.
 TEST(SeparationsTests, SeparationEfficiency) {
@@ -340,5 +443,360 @@ TEST(SeparationsTests, Retire) {
   EXPECT_EQ(3.0, qr.rows.size())
       << "failed to discharge all material before decomissioning";
  }  
+
+TEST(SeparationsTests, SepTableSplit) {
+  CompMap comp;
+  comp[id("U235")] = 10;
+  comp[id("U238")] = 90;
+  comp[id("Pu239")] = 1;
+  comp[id("Am241")] = 3;
+  Composition::Ptr c = Composition::CreateFromMass(comp);
+  Material::Ptr mat = Material::CreateUntracked(100, c);
+
+  std::vector<std::map<int, double> > effs(2);
+  effs[0][id("U")] = .7;
+  effs[1][id("Pu")] = 1;
+
+  SepTable table;
+  table.Init(effs);
+  const SepSplit& split = table.Split(c);
+  ASSERT_EQ(2, split.fracs.size());
+  ASSERT_EQ(2, split.comps.size());
+  ASSERT_TRUE(split.left);
+
+  for (int s = 0; s < 2; s++) {
+    Material::Ptr want = SepMaterial(effs[s], mat);
+    EXPECT_NEAR(want->quantity(), split.fracs[s] * mat->quantity(), 1e-10);
+    MatQuery mqwant(want);
+    MatQuery mqgot(Material::CreateUntracked(want->quantity(),
+                                             split.comps[s]));
+    EXPECT_NEAR(mqwant.mass("U235"), mqgot.mass("U235"), 1e-10);
+    EXPECT_NEAR(mqwant.mass("Pu239"), mqgot.mass("Pu239"), 1e-10);
+    EXPECT_DOUBLE_EQ(0, mqgot.mass("Am241"));
+  }
+
+  // repeat splits of the same feed are interned
+  const SepSplit& again = table.Split(c);
+  EXPECT_EQ(&split, &again);
+  EXPECT_EQ(split.comps[0]->id(), again.comps[0]->id());
+  EXPECT_EQ(split.left->id(), again.left->id());
+}
+
+// separating the same feed every time step should reuse a single stream
+// composition rather than recording a new one per step.
+TEST(SeparationsTests, InternedStreamComps) {
+  std::string config =
+      "<streams>"
+      "    <item>"
+      "        <commod>stream1</commod>"
+      "        <info>"
+      "            <buf_size>-1</buf_size>"
+      "            <efficiencies>"
+      "                <item><comp>U</comp> <eff>0.6</eff></item>"
+      "            </efficiencies>"
+      "        </info>"
+      "    </item>"
+      "</streams>"
+      ""
+      "<leftover_commod>waste</leftover_commod>"
+      "<throughput>10</throughput>"
+      "<feedbuf_size>100</feedbuf_size>"
+      "<feed_commods> <val>feed</val> </feed_commods>"
+     ;
+
+  CompMap m;
+  m[id("u235")] = 0.1;
+  m[id("u238")] = 0.8;
+  m[id("pu239")] = 0.1;
+  Composition::Ptr c = Composition::CreateFromMass(m);
+
+  int simdur = 5;
+  cyclus::MockSim sim(cyclus::AgentSpec(":cycamore:Separations"), config, simdur);
+  sim.AddSource("feed").recipe("recipe1").capacity(10).Finalize();
+  sim.AddSink("stream1").capacity(100).Finalize();
+  sim.AddRecipe("recipe1", c);
+  int id = sim.Run();
+
+  std::vector<Cond> conds;
+  conds.push_back(Cond("SenderId", "==", id));
+  conds.push_back(Cond("Commodity", "==", std::string("stream1")));
+  QueryResult qr = sim.db().Query("Transactions", &conds);
+  ASSERT_EQ(simdur - 1, qr.rows.size());
+
+  std::set<int> qualids;
+  for (int i = 0; i < qr.rows.size(); i++) {
+    conds.clear();
+    conds.push_back(Cond("ResourceId", "==", qr.GetVal<int>("ResourceId", i)));
+    QueryResult res = sim.db().Query("Resources", &conds);
+    qualids.insert(res.GetVal<int>("QualId"));
+  }
+  EXPECT_EQ(1, qualids.size());
+}
+
+// in pipelined mode each feed lot keeps its own composition through
+// separation and partially processed lots carry over to the next step.
+TEST(SeparationsTests, Pipelined) {
+  std::string config =
+      "<streams>"
+      "    <item>"
+      "        <commod>stream1</commod>"
+      "        <info>"
+      "            <buf_size>-1</buf_size>"
+      "            <efficiencies>"
+      "                <item><comp>U</comp> <eff>0.5</eff></item>"
+      "            </efficiencies>"
+      "        </info>"
+      "    </item>"
+      "</streams>"
+      ""
+      "<leftover_commod>waste</leftover_commod>"
+      "<throughput>15</throughput>"
+      "<pipelined>1</pipelined>"
+      "<feedbuf_size>100</feedbuf_size>"
+      "<feed_commods> <val>feed</val> </feed_commods>"
+     ;
+
+  CompMap m;
+  m[id("u235")] = 1;
+  Composition::Ptr c235 = Composition::CreateFromMass(m);
+  m.clear();
+  m[id("u238")] = 1;
+  Composition::Ptr c238 = Composition::CreateFromMass(m);
+
+  int simdur = 4;
+  cyclus::MockSim sim(cyclus::AgentSpec(":cycamore:Separations"), config, simdur);
+  sim.AddSource("feed").recipe("u235").capacity(10).lifetime(1).Finalize();
+  sim.AddSource("feed").recipe("u238").capacity(10).lifetime(1).Finalize();
+  sim.AddSink("stream1").capacity(100).Finalize();
+  sim.AddRecipe("u235", c235);
+  sim.AddRecipe("u238", c238);
+  int id = sim.Run();
+
+  std::vector<Cond> conds;
+  conds.push_back(Cond("SenderId", "==", id));
+  conds.push_back(Cond("Commodity", "==", std::string("stream1")));
+  QueryResult qr = sim.db().Query("Transactions", &conds);
+
+  // 15 kg of feed is processed in the first step and the last 5 kg in the
+  // next - half of which goes to stream1 each time.
+  std::map<int, double> sent;
+  for (int i = 0; i < qr.rows.size(); i++) {
+    MatQuery mq(sim.GetMaterial(qr.GetVal<int>("ResourceId", i)));
+    sent[qr.GetVal<int>("Time", i)] += mq.qty();
+
+    // lots are never merged so every output is a single isotope
+    EXPECT_TRUE(mq.mass("U235") == 0 || mq.mass("U238") == 0)
+        << "feed lots were mixed before separation";
+  }
+  EXPECT_NEAR(7.5, sent[1], 1e-10);
+  EXPECT_NEAR(2.5, sent[2], 1e-10);
+  EXPECT_EQ(0, sent.count(3));
+}
+
+// feed that can't be processed because a stream buffer is full must go back
+// to the feed inventory with its original composition.
+TEST(SeparationsTests, FullStreamReturnsFeed) {
+  std::string config =
+      "<streams>"
+      "    <item>"
+      "        <commod>stream1</commod>"
+      "        <info>"
+      "            <buf_size>10</buf_size>"
+      "            <efficiencies>"
+      "                <item><comp>U</comp> <eff>0.5</eff></item>"
+      "            </efficiencies>"
+      "        </info>"
+      "    </item>"
+      "</streams>"
+      ""
+      "<leftover_commod>waste</leftover_commod>"
+      "<throughput>100</throughput>"
+      "<feedbuf_size>100</feedbuf_size>"
+      "<feed_commods> <val>feed</val> </feed_commods>"
+     ;
+
+  CompMap m;
+  m[id("u238")] = 0.5;
+  m[id("pu239")] = 0.5;
+  Composition::Ptr c = Composition::CreateFromMass(m);
+
+  int simdur = 3;
+  cyclus::MockSim sim(cyclus::AgentSpec(":cycamore:Separations"), config, simdur);
+  sim.AddSource("feed").recipe("recipe1").capacity(100).lifetime(1).Finalize();
+  sim.AddSink("stream1").capacity(10).Finalize();
+  sim.AddSink("waste").capacity(1000).Finalize();
+  sim.AddRecipe("recipe1", c);
+  int id = sim.Run();
+
+  // each step only 40 kg of feed (20 kg U) fits the 10 kg stream buffer, so
+  // 10 kg U goes to stream1 and 10 kg U + 20 kg Pu to waste.  The 60 kg sent
+  // back to feed after the first step must still be half U and half Pu for
+  // the second step to do the same.
+  std::vector<Cond> conds;
+  conds.push_back(Cond("SenderId", "==", id));
+  conds.push_back(Cond("Commodity", "==", std::string("waste")));
+  QueryResult qr = sim.db().Query("Transactions", &conds);
+  ASSERT_EQ(2, qr.rows.size());
+  for (int i = 0; i < qr.rows.size(); i++) {
+    MatQuery mq(sim.GetMaterial(qr.GetVal<int>("ResourceId", i)));
+    EXPECT_NEAR(30, mq.qty(), 1e-10);
+    EXPECT_NEAR(10, mq.mass("U238"), 1e-10);
+    EXPECT_NEAR(20, mq.mass("Pu239"), 1e-10);
+  }
+}
+
+// a round-off sized lot at the front of the feed must not stall pipelined
+// processing when a stream buffer is full, and a partly processed lot stays
+// at the front of the queue.
+TEST(SeparationsTests, PipelinedFullStream) {
+  std::string config =
+      "<streams>"
+      "    <item>"
+      "        <commod>stream1</commod>"
+      "        <info>"
+      "            <buf_size>2</buf_size>"
+      "            <efficiencies>"
+      "                <item><comp>U</comp> <eff>0.5</eff></item>"
+      "            </efficiencies>"
+      "        </info>"
+      "    </item>"
+      "</streams>"
+      ""
+      "<leftover_commod>waste</leftover_commod>"
+      "<throughput>100</throughput>"
+      "<pipelined>1</pipelined>"
+      "<feedbuf_size>100</feedbuf_size>"
+      "<feed_commods> <val>feed</val> </feed_commods>"
+     ;
+
+  CompMap m;
+  m[id("u235")] = 1;
+  Composition::Ptr c235 = Composition::CreateFromMass(m);
+  m.clear();
+  m[id("u238")] = 1;
+  Composition::Ptr c238 = Composition::CreateFromMass(m);
+
+  cyclus::MockSim sim(cyclus::AgentSpec(":cycamore:Separations"), config, 1);
+  sim.Run();
+  Separations* sep = dynamic_cast<Separations*>(sim.agent);
+  ASSERT_TRUE(sep != NULL);
+
+  cyclus::Inventories invs;
+  invs["feed-inv-name"].push_back(Material::CreateUntracked(1e-9, c238));
+  invs["feed-inv-name"].push_back(Material::CreateUntracked(10, c235));
+  invs["feed-inv-name"].push_back(Material::CreateUntracked(10, c238));
+  sep->InitInv(invs);
+
+  // only 4 kg of the u235 lot fits the 2 kg stream buffer.  The second tick
+  // finds the stream buffer full and does nothing.
+  sep->Tick();
+  sep->Tick();
+
+  invs = sep->SnapshotInv();
+  ASSERT_EQ(2, invs["feed-inv-name"].size());
+  MatQuery front(boost::dynamic_pointer_cast<Material>(invs["feed-inv-name"][0]));
+  EXPECT_NEAR(6, front.qty(), 1e-10);
+  EXPECT_NEAR(6, front.mass("U235"), 1e-10);
+  MatQuery back(boost::dynamic_pointer_cast<Material>(invs["feed-inv-name"][1]));
+  EXPECT_NEAR(10, back.mass("U238"), 1e-10);
+
+  double stream = 0;
+  for (int i = 0; i < invs["stream1"].size(); i++) {
+    stream += invs["stream1"][i]->quantity();
+  }
+  EXPECT_NEAR(2, stream, 1e-10);
+  double waste = 0;
+  for (int i = 0; i < invs["leftover-inv-name"].size(); i++) {
+    waste += invs["leftover-inv-name"][i]->quantity();
+  }
+  EXPECT_NEAR(2, waste, 1e-8);
+}
+
+// stream buffers are snapshotted by commodity and restored into the right
+// slots, even though the slots follow streams_ order rather than input order.
+TEST(SeparationsTests, InventoryRoundTrip) {
+  std::string config =
+      "<streams>"
+      "    <item>"
+      "        <commod>pu</commod>"
+      "        <info>"
+      "            <buf_size>-1</buf_size>"
+      "            <efficiencies>"
+      "                <item><comp>Pu</comp> <eff>1</eff></item>"
+      "            </efficiencies>"
+      "        </info>"
+      "    </item>"
+      "    <item>"
+      "        <commod>am</commod>"
+      "        <info>"
+      "            <buf_size>-1</buf_size>"
+      "            <efficiencies>"
+      "                <item><comp>Am</comp> <eff>1</eff></item>"
+      "            </efficiencies>"
+      "        </info>"
+      "    </item>"
+      "</streams>"
+      ""
+      "<leftover_commod>waste</leftover_commod>"
+      "<throughput>100</throughput>"
+      "<feedbuf_size>100</feedbuf_size>"
+      "<feed_commods> <val>feed</val> </feed_commods>"
+     ;
+
+  CompMap m;
+  m[id("u238")] = 7;
+  m[id("pu239")] = 2;
+  m[id("am241")] = 1;
+  Composition::Ptr c = Composition::CreateFromMass(m);
+
+  int simdur = 3;
+  cyclus::MockSim sim(cyclus::AgentSpec(":cycamore:Separations"), config, simdur);
+  sim.AddSource("feed").recipe("recipe1").capacity(10).Finalize();
+  sim.AddRecipe("recipe1", c);
+  sim.Run();
+
+  Separations* sep = dynamic_cast<Separations*>(sim.agent);
+  ASSERT_TRUE(sep != NULL);
+  cyclus::Inventories invs = sep->SnapshotInv();
+  ASSERT_FALSE(invs["pu"].empty());
+  ASSERT_FALSE(invs["am"].empty());
+
+  Separations* restored = dynamic_cast<Separations*>(sep->Clone());
+  restored->InitInv(invs);
+  cyclus::Inventories back = restored->SnapshotInv();
+
+  ASSERT_EQ(invs.size(), back.size());
+  cyclus::Inventories::iterator it;
+  for (it = invs.begin(); it != invs.end(); ++it) {
+    ASSERT_EQ(1, back.count(it->first)) << it->first;
+    std::vector<cyclus::Resource::Ptr>& rs = back[it->first];
+    ASSERT_EQ(it->second.size(), rs.size()) << it->first;
+    for (int i = 0; i < rs.size(); i++) {
+      EXPECT_EQ(it->second[i]->obj_id(), rs[i]->obj_id()) << it->first;
+    }
+  }
+
+  // each stream's material landed back in its own buffer
+  double pu = 0;
+  for (int i = 0; i < back["pu"].size(); i++) {
+    MatQuery mq(boost::dynamic_pointer_cast<Material>(back["pu"][i]));
+    EXPECT_DOUBLE_EQ(0, mq.mass("Am241"));
+    pu += mq.mass("Pu239");
+  }
+  // feed received at t=0 and t=1 is separated; the last 10 kg is still feed
+  EXPECT_NEAR(4, pu, 1e-10);
+  double am = 0;
+  for (int i = 0; i < back["am"].size(); i++) {
+    MatQuery mq(boost::dynamic_pointer_cast<Material>(back["am"][i]));
+    EXPECT_DOUBLE_EQ(0, mq.mass("Pu239"));
+    am += mq.mass("Am241");
+  }
+  EXPECT_NEAR(2, am, 1e-10);
+  ASSERT_EQ(1, back["feed-inv-name"].size());
+  EXPECT_NEAR(10, back["feed-inv-name"][0]->quantity(), 1e-10);
+  EXPECT_FALSE(restored->CheckDecommissionCondition());
+  delete restored;
+}
+
 } // namespace cycamore
 
@@ -11,7 +11,9 @@ namespace cycamore {
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 Sink::Sink(cyclus::Context* ctx)
     : cyclus::Facility(ctx),
-      capacity(std::numeric_limits<double>::max()) {
+      capacity(std::numeric_limits<double>::max()),
+      compaction("none"),
+      tally_interval(0) {
   SetMaxInventorySize(std::numeric_limits<double>::max());
 }
 
@@ -51,6 +53,10 @@ void Sink::EnterNotify() {
     throw cyclus::ValueError(ss.str());
   }
 
+  if (compaction != "none" && compaction != "composition" &&
+      compaction != "nuclide") {
+    throw cyclus::ValueError("unknown sink compaction '" + compaction + "'");
+  }
 }
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -135,17 +141,78 @@ Sink::GetGenRsrcRequests() {
   return ports;
 }
 
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Adds the mass of each nuclide in m to tally.
+static void AddMasses(cyclus::Material::Ptr m, cyclus::CompMap* tally) {
+  const cyclus::CompMap& mass = m->comp()->mass();
+  cyclus::CompMap::const_iterator nuc;
+  double tot = 0;
+  for (nuc = mass.begin(); nuc != mass.end(); ++nuc) {
+    tot += nuc->second;
+  }
+  if (tot <= 0) {
+    return;
+  }
+  double scale = m->quantity() / tot;
+  for (nuc = mass.begin(); nuc != mass.end(); ++nuc) {
+    (*tally)[nuc->first] += nuc->second * scale;
+  }
+}
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 void Sink::AcceptMatlTrades(
     const std::vector< std::pair<cyclus::Trade<cyclus::Material>,
                                  cyclus::Material::Ptr> >& responses) {
   std::vector< std::pair<cyclus::Trade<cyclus::Material>,
                          cyclus::Material::Ptr> >::const_iterator it;
+  if (compaction == "nuclide") {
+    for (it = responses.begin(); it != responses.end(); ++it) {
+      AddMasses(it->second, &nuc_masses);
+    }
+    return;
+  } else if (compaction == "composition") {
+    cyclus::toolkit::MatVec mats;
+    for (it = responses.begin(); it != responses.end(); ++it) {
+      mats.push_back(it->second);
+    }
+    Compact_(mats);
+    return;
+  }
   for (it = responses.begin(); it != responses.end(); ++it) {
     inventory.Push(it->second);
   }
 }
 
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void Sink::Compact_(const cyclus::toolkit::MatVec& mats) {
+  using cyclus::Material;
+
+  // a compacted inventory only holds one material per composition (plus any
+  // products), so it stays small enough to read back in full once per step
+  std::vector<cyclus::Resource::Ptr> held = inventory.PopN(inventory.count());
+  std::map<int, Material::Ptr> running;
+  for (int i = 0; i < held.size(); ++i) {
+    if (held[i]->type() == Material::kType) {
+      Material::Ptr m = cyclus::ResCast<Material>(held[i]);
+      running.insert(std::make_pair(m->comp()->id(), m));
+    }
+  }
+
+  // arrivals only merge with material of the same composition, which adds
+  // up quantities without creating a new composition
+  for (int i = 0; i < mats.size(); ++i) {
+    int comp = mats[i]->comp()->id();
+    std::map<int, Material::Ptr>::iterator it = running.find(comp);
+    if (it != running.end()) {
+      it->second->Absorb(mats[i]);
+    } else {
+      running[comp] = mats[i];
+      held.push_back(mats[i]);
+    }
+  }
+  inventory.Push(held);
+}
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 void Sink::AcceptGenRsrcTrades(
     const std::vector< std::pair<cyclus::Trade<cyclus::Product>,
@@ -187,9 +254,46 @@ void Sink::Tock() {
                                    << " is holding " << inventory.quantity()
                                    << " units of material at the close of month "
                                    << context()->time() << ".";
+
+  if (tally_interval > 0 && context()->time() % tally_interval == 0) {
+    RecordTally_();
+  }
   LOG(cyclus::LEV_INFO3, "SnkFac") << "}";
 }
 
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void Sink::RecordTally_() {
+  cyclus::CompMap tally = nuc_masses;
+  std::vector<cyclus::Resource::Ptr> rs = inventory.PopN(inventory.count());
+  inventory.Push(rs);
+  for (int i = 0; i < rs.size(); i++) {
+    cyclus::Resource::Ptr r = rs[i];
+    if (r->type() == cyclus::Material::kType) {
+      AddMasses(cyclus::ResCast<cyclus::Material>(r), &tally);
+    }
+  }
+
+  cyclus::CompMap::iterator it;
+  for (it = tally.begin(); it != tally.end(); ++it) {
+    context()->NewDatum("SinkTally")
+        ->AddVal("AgentId", id())
+        ->AddVal("Time", context()->time())
+        ->AddVal("NucId", it->first)
+        ->AddVal("Mass", it->second)
+        ->Record();
+  }
+}
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+double Sink::TalliedQty_() const {
+  double qty = 0;
+  std::map<int, double>::const_iterator it;
+  for (it = nuc_masses.begin(); it != nuc_masses.end(); ++it) {
+    qty += it->second;
+  }
+  return qty;
+}
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 extern "C" cyclus::Agent* ConstructSink(cyclus::Context* ctx) {
   return new Sink(ctx);
@@ -2,6 +2,7 @@
 #define CYCAMORE_SRC_SINK_H_
 
 #include <algorithm>
+#include <map>
 #include <string>
 #include <utility>
 #include <vector>
@@ -82,11 +83,14 @@ class Sink : public cyclus::Facility  {
   inline double MaxInventorySize() const { return inventory.capacity(); }
 
   /// @return the current inventory storage size
-  inline double InventorySize() const { return inventory.quantity(); }
+  inline double InventorySize() const {
+    return inventory.quantity() + TalliedQty_();
+  }
 
   /// determines the amount to request
   inline double RequestAmt() const {
-    return std::min(capacity, std::max(0.0, inventory.space()));
+    return std::min(capacity,
+                    std::max(0.0, inventory.space() - TalliedQty_()));
   }
 
   /// sets the capacity of a material generated at any given time step
@@ -105,6 +109,18 @@ class Sink : public cyclus::Facility  {
       input_commodity_preferences() const { return in_commod_prefs; }
 
  private:
+  /// absorbs each of mats into the running material of the same composition
+  /// held in the inventory, or adds it as the running material for its
+  /// composition if there is none
+  void Compact_(const cyclus::toolkit::MatVec& mats);
+
+  /// records the mass of each nuclide in the inventory (including nuclide
+  /// tallies) to the SinkTally table
+  void RecordTally_();
+
+  /// @return the total mass reduced to nuclide tallies
+  double TalliedQty_() const;
+
   /// all facilities must have at least one input commodity
   #pragma cyclus var {"tooltip": "input commodities", \
                       "doc": "commodities that the sink facility accepts", \
@@ -148,6 +164,38 @@ class Sink : public cyclus::Facility  {
                              "accept at each time step"}
   double capacity;
 
+  /// how accepted material is held: "none", "composition" or "nuclide"
+  #pragma cyclus var {"default": "none", \
+                      "tooltip": "inventory compaction", \
+                      "uilabel": "Inventory Compaction", \
+                      "uitype": "combobox", \
+                      "categorical": ["none", "composition", "nuclide"], \
+                      "doc": "how accepted material is held. 'none' keeps " \
+                             "every accepted resource separately. " \
+                             "'composition' absorbs material into one running " \
+                             "material per composition, so memory grows with " \
+                             "the number of distinct compositions received. " \
+                             "'nuclide' reduces material to a mass tally per " \
+                             "nuclide and holds no material at all; use " \
+                             "tally_interval to record the tallies. Products " \
+                             "are always held separately."}
+  std::string compaction;
+
+  /// mass of each nuclide accepted while compaction is "nuclide"
+  #pragma cyclus var {"default": {}, \
+                      "internal": True}
+  std::map<int, double> nuc_masses;
+
+  /// interval between nuclide mass tallies
+  #pragma cyclus var {"default": 0, \
+                      "tooltip": "tally interval", \
+                      "uilabel": "Tally Interval", \
+                      "units": "time steps", \
+                      "doc": "if positive, the mass of each nuclide held by " \
+                             "the sink is recorded to the SinkTally table " \
+                             "every tally_interval time steps"}
+  int tally_interval;
+
   /// this facility holds material in storage.
   #pragma cyclus var {'capacity': 'max_inv_size'}
   cyclus::toolkit::ResBuf<cyclus::Resource> inventory;
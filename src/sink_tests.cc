@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 
+#include <sstream>
+
 #include "facility_tests.h"
 #include "agent_tests.h"
 #include "resource_helpers.h"
@@ -264,6 +266,64 @@ TEST_F(SinkTest, BidPrefs) {
   EXPECT_EQ(0, qr2.rows.size());
   
 }
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+TEST_F(SinkTest, CompactTally) {
+  using cyclus::QueryResult;
+  using cyclus::Cond;
+
+  cyclus::CompMap m1;
+  m1[922350000] = 1;
+  cyclus::CompMap m2;
+  m2[922380000] = 1;
+
+  // every compaction mode tallies the same as one holding every resource
+  std::string modes[] = {"none", "composition", "nuclide"};
+  int nheld[] = {6, 2, 0};
+  for (int mode = 0; mode < 3; ++mode) {
+    std::stringstream config;
+    config << "<in_commods> <val>commods_1</val> <val>commods_2</val>"
+           << "</in_commods>"
+           << "<compaction>" << modes[mode] << "</compaction>"
+           << "<tally_interval>2</tally_interval>";
+
+    int simdur = 3;
+    cyclus::MockSim sim(cyclus::AgentSpec(":cycamore:Sink"), config.str(),
+                        simdur);
+    sim.AddRecipe("u235", cyclus::Composition::CreateFromMass(m1));
+    sim.AddRecipe("u238", cyclus::Composition::CreateFromMass(m2));
+    sim.AddSource("commods_1").recipe("u235").capacity(1).Finalize();
+    sim.AddSource("commods_2").recipe("u238").capacity(2).Finalize();
+    int id = sim.Run();
+
+    // compacting by composition keeps one material per composition rather
+    // than merging the two feeds into a new blended composition, and
+    // compacting by nuclide holds no material at all
+    cyclus::Inventories invs = sim.agent->SnapshotInv();
+    std::vector<cyclus::Resource::Ptr>& held = invs["inventory"];
+    EXPECT_EQ(nheld[mode], held.size()) << "compaction=" << modes[mode];
+    for (int i = 0; i < held.size(); ++i) {
+      cyclus::Material::Ptr m = cyclus::ResCast<cyclus::Material>(held[i]);
+      EXPECT_EQ(1, m->comp()->mass().size()) << "compaction=" << modes[mode];
+    }
+    cycamore::Sink* snk = dynamic_cast<cycamore::Sink*>(sim.agent);
+    EXPECT_NEAR(9, snk->InventorySize(), 1e-10) << "compaction=" << modes[mode];
+
+    // tallies are taken at t=0 and t=2 only
+    QueryResult qr = sim.db().Query("SinkTally", NULL);
+    EXPECT_EQ(4, qr.rows.size()) << "compaction=" << modes[mode];
+
+    std::vector<Cond> conds;
+    conds.push_back(Cond("Time", "==", 2));
+    qr = sim.db().Query("SinkTally", &conds);
+    ASSERT_EQ(2, qr.rows.size()) << "compaction=" << modes[mode];
+    for (int i = 0; i < qr.rows.size(); ++i) {
+      double want = qr.GetVal<int>("NucId", i) == 922350000 ? 3 : 6;
+      EXPECT_NEAR(want, qr.GetVal<double>("Mass", i), 1e-10)
+          << "compaction=" << modes[mode];
+    }
+  }
+}
+
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 TEST_F(SinkTest, Print) {
   EXPECT_NO_THROW(std::string s = src_facility->str());
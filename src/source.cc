@@ -1,5 +1,8 @@
 #include "source.h"
 
+#include <algorithm>
+#include <cctype>
+#include <fstream>
 #include <sstream>
 #include <limits>
 
@@ -7,10 +10,19 @@
 
 namespace cycamore {
 
+// Bound on the number of offer materials a Source remembers.
+static const int kMaxBidMats = 100;
+
 Source::Source(cyclus::Context* ctx)
     : cyclus::Facility(ctx),
       throughput(std::numeric_limits<double>::max()),
-      inventory_size(std::numeric_limits<double>::max()) {}
+      inventory_size(std::numeric_limits<double>::max()),
+      bid_cap(-1),
+      sched_pos(0),
+      sched_line(0),
+      sched_throughput(-1),
+      next_time(-1),
+      next_throughput(0) {}
 
 Source::~Source() {}
 
@@ -46,6 +58,91 @@ std::string Source::str() {
   return ss.str();
 }
 
+void Source::EnterNotify() {
+  cyclus::Facility::EnterNotify();
+  if (throughput_file.empty()) {
+    return;
+  }
+
+  std::ifstream sched(throughput_file.c_str());
+  if (!sched.is_open()) {
+    throw cyclus::IOError("could not open throughput_file '" +
+                          throughput_file + "'");
+  }
+  std::string header;
+  std::getline(sched, header);
+  sched_pos = static_cast<int>(sched.tellg());
+  header.erase(std::remove_if(header.begin(), header.end(), ::isspace),
+               header.end());
+  sched_line = 1;
+  if (header != "time,throughput") {
+    throw cyclus::ValueError("throughput_file '" + throughput_file +
+                             "' must start with the header "
+                             "'time,throughput'");
+  }
+  ReadSchedule_();
+  Tick();  // catch up to the current time, e.g. when deployed late
+}
+
+void Source::ReadSchedule_() {
+  int prev = next_time;
+  next_time = -1;
+  if (sched_pos < 0) {
+    return;  // already read to the end
+  }
+
+  // the file is reopened at the saved offset for each entry rather than held
+  // open for the whole run, so large deployments don't run out of file
+  // descriptors.  Entries only change every few time steps at most.
+  std::ifstream sched(throughput_file.c_str());
+  if (!sched.is_open()) {
+    throw cyclus::IOError("could not open throughput_file '" +
+                          throughput_file + "'");
+  }
+  sched.seekg(sched_pos);
+
+  std::string line;
+  while (std::getline(sched, line)) {
+    sched_line++;
+    if (line.find_first_not_of(" \t\r") == std::string::npos) {
+      continue;
+    }
+
+    std::stringstream ss(line);
+    int t;
+    char comma;
+    double val;
+    bool ok = (ss >> t >> comma >> val) && comma == ',';
+    if (ok) {
+      ss >> std::ws;
+      ok = ss.eof();  // nothing may follow the throughput
+    }
+    if (!ok || val < 0 || t <= prev) {
+      std::stringstream msg;
+      msg << "throughput_file '" << throughput_file << "' line " << sched_line
+          << " must hold a time step later than the previous one and a"
+          << " non-negative throughput";
+      throw cyclus::ValueError(msg.str());
+    }
+    next_time = t;
+    next_throughput = val;
+    sched_pos = sched.eof() ? -1 : static_cast<int>(sched.tellg());
+    return;
+  }
+  sched_pos = -1;
+}
+
+void Source::Tick() {
+  while (next_time >= 0 && next_time <= context()->time()) {
+    sched_throughput = next_throughput;
+    ReadSchedule_();
+  }
+}
+
+double Source::Throughput_() {
+  return sched_throughput < 0 ? throughput : sched_throughput;
+}
+
 std::set<cyclus::BidPortfolio<cyclus::Material>::Ptr> Source::GetMatlBids(
     cyclus::CommodMap<cyclus::Material>::type& commod_requests) {
   using cyclus::Bid;
@@ -54,7 +151,7 @@ std::set<cyclus::BidPortfolio<cyclus::Material>::Ptr> Source::GetMatlBids(
   using cyclus::Material;
   using cyclus::Request;
 
-  double max_qty = std::min(throughput, inventory_size);
+  double max_qty = std::min(Throughput_(), inventory_size);
   LOG(cyclus::LEV_INFO3, "Source") << prototype() << " is bidding up to "
                                    << max_qty << " kg of " << outcommod;
   LOG(cyclus::LEV_INFO5, "Source") << "stats: " << str();
@@ -66,16 +163,41 @@ std::set<cyclus::BidPortfolio<cyclus::Material>::Ptr> Source::GetMatlBids(
     return ports;
   }
 
+  std::vector<Request<Material>*> requests = commod_requests[outcommod];
+  if (bid_cap >= 0 && requests.size() > bid_cap) {
+    std::nth_element(requests.begin(), requests.begin() + bid_cap,
+                     requests.end(), PrefersReq);
+    requests.resize(bid_cap);
+  }
+  if (requests.empty()) {
+    return ports;
+  }
+
+  cyclus::Composition::Ptr recipe;
+  if (!outrecipe.empty()) {
+    recipe = context()->GetRecipe(outrecipe);
+  }
   BidPortfolio<Material>::Ptr port(new BidPortfolio<Material>());
-  std::vector<Request<Material>*>& requests = commod_requests[outcommod];
   std::vector<Request<Material>*>::iterator it;
   for (it = requests.begin(); it != requests.end(); ++it) {
     Request<Material>* req = *it;
     Material::Ptr target = req->target();
     double qty = std::min(target->quantity(), max_qty);
-    Material::Ptr m = Material::CreateUntracked(qty, target->comp());
-    if (!outrecipe.empty()) {
-      m = Material::CreateUntracked(qty, context()->GetRecipe(outrecipe));
+    cyclus::Composition::Ptr c = recipe ? recipe : target->comp();
+
+    // offers are never modified, so requests for the same composition and
+    // quantity - this step or any other - can share one
+    std::pair<int, double> key = std::make_pair(c->id(), qty);
+    std::map<std::pair<int, double>, Material::Ptr>::iterator found =
+        bid_mats_.find(key);
+    Material::Ptr m;
+    if (found != bid_mats_.end()) {
+      m = found->second;
+    } else {
+      if (bid_mats_.size() >= kMaxBidMats) {
+        bid_mats_.clear();
+      }
+      m = bid_mats_[key] = Material::CreateUntracked(qty, c);
     }
     port->AddBid(req, m, this);
   }
@@ -86,6 +208,22 @@ std::set<cyclus::BidPortfolio<cyclus::Material>::Ptr> Source::GetMatlBids(
   return ports;
 }
 
+bool Source::PrefersReq(cyclus::Request<cyclus::Material>* a,
+                        cyclus::Request<cyclus::Material>* b) {
+  if (a->preference() != b->preference()) {
+    return a->preference() > b->preference();
+  }
+  if (a->target()->quantity() != b->target()->quantity()) {
+    return a->target()->quantity() > b->target()->quantity();
+  }
+  int a_id = a->requester()->manager()->id();
+  int b_id = b->requester()->manager()->id();
+  if (a_id != b_id) {
+    return a_id < b_id;
+  }
+  return a->target()->obj_id() < b->target()->obj_id();
+}
+
 void Source::GetMatlTrades(
     const std::vector<cyclus::Trade<cyclus::Material> >& trades,
     std::vector<std::pair<cyclus::Trade<cyclus::Material>,
@@ -2,6 +2,7 @@
 #define CYCAMORE_SRC_SOURCE_H_
 
 #include <set>
+#include <string>
 #include <vector>
 
 #include "cyclus.h"
@@ -56,7 +57,9 @@ class Source : public cyclus::Facility,
 
   virtual void InitFrom(cyclus::QueryableBackend* b);
 
-  virtual void Tick() {};
+  virtual void EnterNotify();
+
+  virtual void Tick();
 
   virtual void Tock() {};
 
@@ -115,6 +118,72 @@ class Source : public cyclus::Facility,
   }
   double throughput;
 
+  #pragma cyclus var { \
+    "default": -1, \
+    "tooltip": "maximum number of bids per time step", \
+    "uilabel": "Bid Cap", \
+    "doc": "Maximum number of requests bid on in each time step. When there " \
+           "are more requests, only those with the highest preference are " \
+           "bid on, larger requests first among equal preferences, then " \
+           "requests from lower agent ids and finally older requests. A " \
+           "negative value bids on every request.", \
+  }
+  int bid_cap;
+
+  #pragma cyclus var { \
+    "default": "", \
+    "tooltip": "throughput schedule file", \
+    "uilabel": "Throughput Schedule File", \
+    "doc": "Path to a CSV file giving a per time step throughput schedule. " \
+           "The first line must be the header 'time,throughput' and each " \
+           "following line a time step and the throughput (kg/(time step)) " \
+           "that applies from that time step on, in increasing time order. " \
+           "The file is read forward as the simulation runs, so only the " \
+           "current and next entries are held in memory. Before the first " \
+           "entry, the throughput parameter applies. If empty, the " \
+           "throughput parameter always applies.", \
+  }
+  std::string throughput_file;
+
+  /// Returns the throughput in effect for the current time step.
+  double Throughput_();
+
+  /// Reads the next entry of the throughput schedule, starting at sched_pos,
+  /// into next_time and next_throughput, setting next_time to -1 at the end
+  /// of the file.
+  void ReadSchedule_();
+
+  /// Orders requests by decreasing preference, then decreasing quantity,
+  /// then increasing requester id and finally increasing target object id,
+  /// so that which requests survive bid_cap does not depend on the order in
+  /// which they were made.
+  static bool PrefersReq(cyclus::Request<cyclus::Material>* a,
+                         cyclus::Request<cyclus::Material>* b);
+
+  // offer materials keyed by (composition id, quantity) - no need to be a
+  // state var
+  std::map<std::pair<int, double>, cyclus::Material::Ptr> bid_mats_;
+
+  /// file offset of the throughput schedule entry after next, -1 once the
+  /// whole file is read
+  #pragma cyclus var {"default": 0, "internal": True}
+  int sched_pos;
+
+  /// line number of the last throughput schedule line read
+  #pragma cyclus var {"default": 0, "internal": True}
+  int sched_line;
+
+  /// throughput schedule entry in effect, negative before the first one
+  #pragma cyclus var {"default": -1, "internal": True}
+  double sched_throughput;
+
+  /// time step of the next throughput schedule entry, -1 if there is none
+  #pragma cyclus var {"default": -1, "internal": True}
+  int next_time;
+
+  /// throughput of the next throughput schedule entry
+  #pragma cyclus var {"default": 0, "internal": True}
+  double next_throughput;
 };
 
 }  // namespace cycamore
@@ -2,6 +2,8 @@
 
 #include <gtest/gtest.h>
 
+#include <cstdio>
+#include <fstream>
 #include <sstream>
 
 #include "cyc_limits.h"
@@ -80,6 +82,163 @@ TEST_F(SourceTest, AddBids) {
   EXPECT_EQ(*constrs.begin(), CapacityConstraint<Material>(capacity));
 }
 
+TEST_F(SourceTest, SharedOffers) {
+  using cyclus::BidPortfolio;
+  using cyclus::Material;
+
+  int nreqs = 5;
+  boost::shared_ptr< cyclus::ExchangeContext<Material> >
+      ec = GetContext(nreqs, commod);
+
+  // identical requests share one offer, this step and the next
+  std::set<BidPortfolio<Material>::Ptr> ports =
+      src_facility->GetMatlBids(ec.get()->commod_requests);
+  ASSERT_EQ(1, ports.size());
+  const std::set<cyclus::Bid<Material>*>& bids = (*ports.begin())->bids();
+  ASSERT_EQ(nreqs, bids.size());
+  Material::Ptr offer = (*bids.begin())->offer();
+  std::set<cyclus::Bid<Material>*>::const_iterator it;
+  for (it = bids.begin(); it != bids.end(); ++it) {
+    EXPECT_EQ(offer, (*it)->offer());
+    EXPECT_EQ(recipe, (*it)->offer()->comp());
+  }
+
+  ports = src_facility->GetMatlBids(ec.get()->commod_requests);
+  EXPECT_EQ(offer, (*(*ports.begin())->bids().begin())->offer());
+}
+
+TEST_F(SourceTest, BidCap) {
+  using cyclus::BidPortfolio;
+  using cyclus::ExchangeContext;
+  using cyclus::Material;
+  using cyclus::Request;
+  using test_helpers::get_mat;
+
+  // only the two most preferred requests are bid on
+  double prefs[] = {1, 5, 3, 2, 4};
+  boost::shared_ptr< ExchangeContext<Material> >
+      ec(new ExchangeContext<Material>());
+  for (int i = 0; i < 5; i++) {
+    ec->AddRequest(
+        Request<Material>::Create(get_mat(), trader, commod, prefs[i]));
+  }
+
+  bid_cap(src_facility, 2);
+  std::set<BidPortfolio<Material>::Ptr> ports =
+      src_facility->GetMatlBids(ec.get()->commod_requests);
+  ASSERT_EQ(1, ports.size());
+  const std::set<cyclus::Bid<Material>*>& bids = (*ports.begin())->bids();
+  ASSERT_EQ(2, bids.size());
+  std::set<cyclus::Bid<Material>*>::const_iterator it;
+  for (it = bids.begin(); it != bids.end(); ++it) {
+    EXPECT_GE((*it)->request()->preference(), 4);
+  }
+
+  bid_cap(src_facility, 0);
+  ports = src_facility->GetMatlBids(ec.get()->commod_requests);
+  EXPECT_EQ(0, ports.size());
+}
+
+TEST_F(SourceTest, BidCapTies) {
+  using cyclus::BidPortfolio;
+  using cyclus::ExchangeContext;
+  using cyclus::Material;
+  using cyclus::Request;
+  using test_helpers::get_mat;
+
+  // among otherwise equal requests the oldest targets are bid on, whatever
+  // order the requests arrive in
+  std::vector<Material::Ptr> mats;
+  for (int i = 0; i < 4; i++) {
+    mats.push_back(get_mat());
+  }
+  boost::shared_ptr< ExchangeContext<Material> >
+      ec(new ExchangeContext<Material>());
+  for (int i = mats.size() - 1; i >= 0; i--) {
+    ec->AddRequest(Request<Material>::Create(mats[i], trader, commod));
+  }
+
+  bid_cap(src_facility, 2);
+  std::set<BidPortfolio<Material>::Ptr> ports =
+      src_facility->GetMatlBids(ec.get()->commod_requests);
+  ASSERT_EQ(1, ports.size());
+  const std::set<cyclus::Bid<Material>*>& bids = (*ports.begin())->bids();
+  ASSERT_EQ(2, bids.size());
+  std::set<cyclus::Bid<Material>*>::const_iterator it;
+  for (it = bids.begin(); it != bids.end(); ++it) {
+    Material::Ptr target = (*it)->request()->target();
+    EXPECT_TRUE(target == mats[0] || target == mats[1]);
+  }
+}
+
+TEST_F(SourceTest, ThroughputFile) {
+  using cyclus::Cond;
+  using cyclus::QueryResult;
+
+  std::string fname = "source_throughput_file_test.csv";
+  {
+    std::ofstream f(fname.c_str());
+    f << "time,throughput\n"
+      << "2,3\n"
+      << "\n"
+      << "4,0\n";
+  }
+
+  std::string config =
+      "<outcommod>commod</outcommod>"
+      "<throughput>1</throughput>"
+      "<throughput_file>" + fname + "</throughput_file>";
+
+  // 1 kg per step until t=2, then 3 kg per step until t=4, then nothing
+  int simdur = 6;
+  cyclus::MockSim sim(cyclus::AgentSpec(":cycamore:Source"), config, simdur);
+  sim.AddSink("commod").Finalize();
+  int id = sim.Run();
+  std::remove(fname.c_str());
+
+  double want[] = {1, 1, 3, 3};
+  QueryResult qr = sim.db().Query("Transactions", NULL);
+  ASSERT_EQ(4, qr.rows.size());
+  for (int t = 0; t < 4; t++) {
+    std::vector<Cond> conds;
+    conds.push_back(Cond("Time", "==", t));
+    qr = sim.db().Query("Transactions", &conds);
+    ASSERT_EQ(1, qr.rows.size()) << "t=" << t;
+    cyclus::Material::Ptr m =
+        sim.GetMaterial(qr.GetVal<int>("ResourceId", 0));
+    EXPECT_DOUBLE_EQ(want[t], m->quantity()) << "t=" << t;
+  }
+}
+
+TEST_F(SourceTest, ThroughputFileGarbage) {
+  std::string fname = "source_throughput_file_garbage_test.csv";
+  {
+    std::ofstream f(fname.c_str());
+    f << "time,throughput\n"
+      << "0,1\n"
+      << "2,3.5abc\n";
+  }
+
+  std::string config =
+      "<outcommod>commod</outcommod>"
+      "<throughput_file>" + fname + "</throughput_file>";
+
+  // the bad row is only reached once the first entry takes effect
+  int simdur = 3;
+  cyclus::MockSim sim(cyclus::AgentSpec(":cycamore:Source"), config, simdur);
+  EXPECT_THROW(sim.Run(), cyclus::ValueError);
+
+  // a bad header is the same kind of error as a bad row
+  {
+    std::ofstream f(fname.c_str());
+    f << "time,rate\n"
+      << "0,1\n";
+  }
+  cyclus::MockSim hdr(cyclus::AgentSpec(":cycamore:Source"), config, simdur);
+  EXPECT_THROW(hdr.Run(), cyclus::ValueError);
+  std::remove(fname.c_str());
+}
+
 TEST_F(SourceTest, Response) {
   using cyclus::Bid;
   using cyclus::Material;
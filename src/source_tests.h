@@ -39,6 +39,7 @@ class SourceTest : public ::testing::Test {
     s->outcommod = commod;
   }
   void throughput(cycamore::Source* s, double val) { s->throughput = val; }
+  void bid_cap(cycamore::Source* s, int val) { s->bid_cap = val; }
 
   boost::shared_ptr<cyclus::ExchangeContext<cyclus::Material> > GetContext(
       int nreqs, std::string commodity);
@@ -0,0 +1,198 @@
+#include "staged_storage.h"
+
+#include <algorithm>
+#include <sstream>
+
+using cyclus::Material;
+using cyclus::toolkit::ResBuf;
+
+namespace cycamore {
+
+StagedStorage::StagedStorage(cyclus::Context* ctx) : cyclus::Facility(ctx) {}
+
+cyclus::Inventories StagedStorage::SnapshotInv() {
+  cyclus::Inventories invs;
+  InitStages_();
+
+  invs["inventory"] = inventory.PopNRes(inventory.count());
+  inventory.Push(invs["inventory"]);
+  invs["stocks"] = stocks.PopNRes(stocks.count());
+  stocks.Push(invs["stocks"]);
+  for (int s = 0; s < stagebufs.size(); s++) {
+    std::string name = StageName_(s);
+    invs[name] = stagebufs[s].PopNRes(stagebufs[s].count());
+    stagebufs[s].Push(invs[name]);
+  }
+  return invs;
+}
+
+void StagedStorage::InitInv(cyclus::Inventories& inv) {
+  InitStages_();
+  inventory.Push(inv["inventory"]);
+  stocks.Push(inv["stocks"]);
+  for (int s = 0; s < stagebufs.size(); s++) {
+    cyclus::Inventories::iterator it = inv.find(StageName_(s));
+    if (it != inv.end()) {
+      stagebufs[s].Push(it->second);
+    }
+  }
+}
+
+void StagedStorage::EnterNotify() {
+  cyclus::Facility::EnterNotify();
+
+  int nstages = residence_times.size();
+  std::stringstream ss;
+  if (nstages == 0) {
+    ss << prototype() << " must have at least one stage";
+  } else if (!stage_capacities.empty() && stage_capacities.size() != nstages) {
+    ss << prototype() << " has " << stage_capacities.size()
+       << " stage capacities, expected " << nstages;
+  } else if (!stage_throughputs.empty() &&
+             stage_throughputs.size() != nstages) {
+    ss << prototype() << " has " << stage_throughputs.size()
+       << " stage throughputs, expected " << nstages;
+  } else if (!in_commod_prefs.empty() &&
+             in_commod_prefs.size() != in_commods.size()) {
+    ss << prototype() << " has " << in_commod_prefs.size()
+       << " in_commod_prefs, expected " << in_commods.size();
+  }
+  for (int s = 0; s < nstages; s++) {
+    if (residence_times[s] < 0 && ss.str().empty()) {
+      ss << prototype() << " stage " << s << " has a negative residence time";
+    }
+  }
+  if (!ss.str().empty()) {
+    throw cyclus::ValueError(ss.str());
+  }
+
+  InitStages_();
+
+  cyclus::Composition::Ptr comp =
+      cyclus::Composition::CreateFromAtom(cyclus::CompMap());
+  if (!in_recipe.empty()) {
+    comp = context()->GetRecipe(in_recipe);
+  }
+  buy_policy.Init(this, &inventory, std::string("inventory"));
+  for (int i = 0; i < in_commods.size(); i++) {
+    double pref = in_commod_prefs.empty() ? cyclus::kDefaultPref
+                                          : in_commod_prefs[i];
+    buy_policy.Set(in_commods[i], comp, pref);
+  }
+  buy_policy.Start();
+
+  sell_policy.Init(this, &stocks, std::string("stocks"))
+      .Set(out_commod)
+      .Start();
+}
+
+void StagedStorage::InitStages_() {
+  if (!stagebufs.empty()) {
+    return;
+  }
+
+  stagebufs.resize(residence_times.size());
+  for (int s = 0; s < stage_capacities.size() && s < stagebufs.size(); s++) {
+    stagebufs[s].capacity(stage_capacities[s]);
+  }
+}
+
+std::string StagedStorage::StageName_(int s) {
+  std::stringstream ss;
+  ss << "stage" << s;
+  return ss.str();
+}
+
+int StagedStorage::Offset_(int s) {
+  int n = 0;
+  for (int i = 0; i < s; i++) {
+    n += stagebufs[i].count();
+  }
+  return n;
+}
+
+void StagedStorage::Tick() {
+  if (stagebufs.empty()) {
+    return;
+  }
+  // material is only bought for the space left in the first stage
+  inventory.capacity(stagebufs[0].space());
+}
+
+void StagedStorage::Tock() {
+  if (!inventory.empty()) {
+    Enter_(0, cyclus::toolkit::Squash(inventory.PopN(inventory.count())));
+  }
+
+  for (int s = 0; s < stagebufs.size(); s++) {
+    Advance_(s);
+  }
+
+  LOG(cyclus::LEV_INFO3, "SStore") << prototype() << " holds "
+                                   << stocks.quantity() << " kg of "
+                                   << out_commod << " ready to ship";
+}
+
+void StagedStorage::Enter_(int s, Material::Ptr m) {
+  int t = context()->time();
+  int end = Offset_(s + 1);
+  if (end > Offset_(s) && entry_times[end - 1] == t) {
+    Material::Ptr last = stagebufs[s].PopBack();
+    last->Absorb(m);
+    m = last;
+  } else {
+    entry_times.insert(entry_times.begin() + end, t);
+  }
+  stagebufs[s].Push(m);
+}
+
+void StagedStorage::Advance_(int s) {
+  ResBuf<Material>& buf = stagebufs[s];
+  if (buf.empty()) {
+    return;
+  }
+
+  // cohorts that have completed their residence time are at the front
+  int first = Offset_(s);
+  int ready_time = context()->time() - residence_times[s];
+  cyclus::toolkit::MatVec mats = buf.PopN(buf.count());
+  buf.Push(mats);
+  double ready = 0;
+  int n = 0;
+  for (; n < mats.size() && entry_times[first + n] <= ready_time; n++) {
+    ready += mats[n]->quantity();
+  }
+  if (n == 0) {
+    return;
+  }
+
+  double qty = ready;
+  if (!stage_throughputs.empty()) {
+    qty = std::min(qty, stage_throughputs[s]);
+  }
+  bool last = s == stagebufs.size() - 1;
+  if (!last) {
+    qty = std::min(qty, stagebufs[s + 1].space());
+  }
+  if (qty < cyclus::eps_rsrc()) {
+    return;
+  }
+
+  int before = buf.count();
+  Material::Ptr m = buf.Pop(qty, cyclus::eps_rsrc());
+  int gone = before - buf.count();
+  entry_times.erase(entry_times.begin() + first,
+                    entry_times.begin() + first + gone);
+
+  if (last) {
+    stocks.Push(m);
+  } else {
+    Enter_(s + 1, m);
+  }
+}
+
+extern "C" cyclus::Agent* ConstructStagedStorage(cyclus::Context* ctx) {
+  return new StagedStorage(ctx);
+}
+
+}  // namespace cycamore
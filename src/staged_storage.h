@@ -0,0 +1,169 @@
+#ifndef CYCAMORE_SRC_STAGED_STORAGE_H_
+#define CYCAMORE_SRC_STAGED_STORAGE_H_
+
+#include <string>
+#include <vector>
+
+#include "cyclus.h"
+#include "cycamore_version.h"
+
+namespace cycamore {
+
+/// StagedStorage holds material in an ordered series of storage stages within
+/// a single agent, e.g. a cooling pool followed by dry casks followed by
+/// transport staging.  Each stage has its own residence time, capacity and
+/// throughput.  Material received on any of the input commodities enters the
+/// first stage.  Once it has spent the stage's residence time there, it moves
+/// to the next stage, as limited by the stage throughput and the space left in
+/// the next stage.  Material leaving the last stage is offered on the output
+/// commodity.  Moves between stages happen on the tock without going through
+/// the market, so a material can pass through several stages with zero
+/// residence time in one time step.
+///
+/// All materials entering a stage in the same time step are combined into a
+/// single cohort.  Material moved out of a stage may be split from a cohort.
+class StagedStorage : public cyclus::Facility {
+#pragma cyclus note { \
+  "niche": "storage", \
+  "doc": \
+  "StagedStorage holds material in an ordered series of storage stages within" \
+  " a single agent, e.g. a cooling pool followed by dry casks followed by" \
+  " transport staging.  Each stage has its own residence time, capacity and" \
+  " throughput.  Material received on any of the input commodities enters the" \
+  " first stage.  Once it has spent the stage's residence time there, it moves" \
+  " to the next stage, as limited by the stage throughput and the space left" \
+  " in the next stage.  Material leaving the last stage is offered on the" \
+  " output commodity.  Moves between stages happen within the facility" \
+  " without trading, so a chain of stages costs one agent instead of one per" \
+  " stage.", \
+}
+
+ public:
+  StagedStorage(cyclus::Context* ctx);
+  virtual ~StagedStorage() {}
+
+  virtual std::string version() { return CYCAMORE_VERSION; }
+
+  virtual void EnterNotify();
+  virtual void Tick();
+  virtual void Tock();
+
+  #pragma cyclus clone
+  #pragma cyclus initfromcopy
+  #pragma cyclus infiletodb
+  #pragma cyclus initfromdb
+  #pragma cyclus schema
+  #pragma cyclus annotations
+  #pragma cyclus snapshot
+  // the following pragmas are ommitted and the functions are written
+  // manually in order to handle the vector of stage buffers:
+  //
+  //     #pragma cyclus snapshotinv
+  //     #pragma cyclus initinv
+
+  virtual cyclus::Inventories SnapshotInv();
+  virtual void InitInv(cyclus::Inventories& inv);
+
+ private:
+  /// Sizes stagebufs to match residence_times and applies the stage
+  /// capacities.  Safe to call more than once.
+  void InitStages_();
+
+  /// Returns the index in entry_times of the first cohort of stage s.  Passing
+  /// the number of stages gives the total number of cohorts.
+  int Offset_(int s);
+
+  /// Adds m to stage s as part of the current time step's cohort.
+  void Enter_(int s, cyclus::Material::Ptr m);
+
+  /// Moves as much of the material in stage s that has completed its
+  /// residence time as allowed into the next stage, or into stocks from the
+  /// last stage.
+  void Advance_(int s);
+
+  /// Returns the inventory name used for stage s.
+  std::string StageName_(int s);
+
+  #pragma cyclus var { \
+    "doc": "Commodities accepted by this facility.", \
+    "uilabel": "Input Commodities", \
+    "uitype": ["oneormore", "incommodity"], \
+  }
+  std::vector<std::string> in_commods;
+
+  #pragma cyclus var { \
+    "default": [], \
+    "doc": "Preferences for each of the given input commodities (same order)." \
+           " If unspecified, default is to use 1.0 for all preferences.", \
+    "uilabel": "Input Commodity Preferences", \
+  }
+  std::vector<double> in_commod_prefs;
+
+  #pragma cyclus var { \
+    "default": "", \
+    "doc": "Recipe accepted by this facility. If unspecified a dummy recipe" \
+           " is used.", \
+    "uilabel": "Input Recipe", \
+    "uitype": "inrecipe", \
+  }
+  std::string in_recipe;
+
+  #pragma cyclus var { \
+    "doc": "Commodity on which material leaving the last stage is offered.", \
+    "uilabel": "Output Commodity", \
+    "uitype": "outcommodity", \
+  }
+  std::string out_commod;
+
+  #pragma cyclus var { \
+    "doc": "Minimum holding time in each stage, in stage order. The number of" \
+           " values sets the number of stages.", \
+    "uilabel": "Stage Residence Times", \
+    "units": "time steps", \
+  }
+  std::vector<int> residence_times;
+
+  #pragma cyclus var { \
+    "default": [], \
+    "doc": "Maximum quantity of material held in each stage, in stage order." \
+           " If unspecified, stages are unlimited.", \
+    "uilabel": "Stage Capacities", \
+    "units": "kg", \
+  }
+  std::vector<double> stage_capacities;
+
+  #pragma cyclus var { \
+    "default": [], \
+    "doc": "Maximum quantity of material that can leave each stage per time" \
+           " step, in stage order. If unspecified, stages are unlimited.", \
+    "uilabel": "Stage Throughputs", \
+    "units": "kg/(time step)", \
+  }
+  std::vector<double> stage_throughputs;
+
+  #pragma cyclus var {"tooltip": "Incoming material buffer"}
+  cyclus::toolkit::ResBuf<cyclus::Material> inventory;
+
+  #pragma cyclus var {"tooltip": "Output material buffer"}
+  cyclus::toolkit::ResBuf<cyclus::Material> stocks;
+
+  // entry time of each cohort in stagebufs, stage by stage and oldest first
+  // within a stage.  Each stage holds one material per cohort, so stage s
+  // owns the stagebufs[s].count() entries starting at Offset_(s).
+  #pragma cyclus var { \
+    "default": [], \
+    "internal": True, \
+  }
+  std::vector<int> entry_times;
+
+  // custom SnapshotInv and InitInv and EnterNotify are used to persist this
+  // state var.  Buffers are indexed by stage.
+  std::vector<cyclus::toolkit::ResBuf<cyclus::Material> > stagebufs;
+
+  cyclus::toolkit::MatlBuyPolicy buy_policy;
+  cyclus::toolkit::MatlSellPolicy sell_policy;
+};
+
+}  // namespace cycamore
+
+#endif  // CYCAMORE_SRC_STAGED_STORAGE_H_
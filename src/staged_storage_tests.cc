@@ -0,0 +1,139 @@
+#include "staged_storage.h"
+
+#include <gtest/gtest.h>
+#include "cyclus.h"
+
+#include "agent_tests.h"
+#include "facility_tests.h"
+
+using cyclus::QueryResult;
+using cyclus::Cond;
+
+namespace cycamore {
+
+// Sums the quantity and counts the transactions on commod.
+static void TransSum(cyclus::MockSim& sim, std::string commod, int* n,
+                     double* qty) {
+  cyclus::SqlStatement::Ptr stmt = sim.db().db().Prepare(
+      "SELECT COUNT(*), TOTAL(r.Quantity) FROM Transactions AS t"
+      " INNER JOIN Resources AS r ON r.ResourceId = t.ResourceId"
+      " WHERE t.Commodity = ?;"
+      );
+  stmt->BindText(1, commod.c_str());
+  stmt->Step();
+  *n = stmt->GetInt(0);
+  *qty = stmt->GetDouble(1);
+}
+
+TEST(StagedStorageTests, ResidenceTimes) {
+  // material spends 1 step in the first stage and 2 in the second, so what
+  // is received at t=0 reaches stocks at t=3 and is shipped at t=4
+  std::string config =
+      "<in_commods> <val>spent_fuel</val> </in_commods>"
+      "<out_commod>dry_spent</out_commod>"
+      "<residence_times> <val>1</val> <val>2</val> </residence_times>";
+
+  int simdur = 6;
+  cyclus::MockSim sim(cyclus::AgentSpec(":cycamore:StagedStorage"), config,
+                      simdur);
+  sim.AddSource("spent_fuel").capacity(10).Finalize();
+  sim.AddSink("dry_spent").Finalize();
+  int id = sim.Run();
+
+  std::vector<Cond> conds;
+  conds.push_back(Cond("Commodity", "==", std::string("dry_spent")));
+  QueryResult qr = sim.db().Query("Transactions", &conds);
+  ASSERT_EQ(2, qr.rows.size());
+  EXPECT_EQ(4, qr.GetVal<int>("Time", 0));
+  EXPECT_EQ(5, qr.GetVal<int>("Time", 1));
+
+  int n;
+  double qty;
+  TransSum(sim, "dry_spent", &n, &qty);
+  EXPECT_DOUBLE_EQ(20, qty);
+}
+
+TEST(StagedStorageTests, StageThroughput) {
+  // zero residence stages pass material on within the time step, but only 4
+  // kg per step can leave the last stage
+  std::string config =
+      "<in_commods> <val>spent_fuel</val> </in_commods>"
+      "<out_commod>dry_spent</out_commod>"
+      "<residence_times> <val>0</val> <val>0</val> </residence_times>"
+      "<stage_throughputs> <val>100</val> <val>4</val> </stage_throughputs>";
+
+  int simdur = 3;
+  cyclus::MockSim sim(cyclus::AgentSpec(":cycamore:StagedStorage"), config,
+                      simdur);
+  sim.AddSource("spent_fuel").capacity(10).Finalize();
+  sim.AddSink("dry_spent").Finalize();
+  int id = sim.Run();
+
+  int n;
+  double qty;
+  TransSum(sim, "spent_fuel", &n, &qty);
+  EXPECT_DOUBLE_EQ(30, qty);
+  TransSum(sim, "dry_spent", &n, &qty);
+  EXPECT_EQ(2, n);
+  EXPECT_DOUBLE_EQ(8, qty);
+}
+
+TEST(StagedStorageTests, StageCapacity) {
+  // the first stage holds at most 15 kg for 2 steps, so nothing can be
+  // bought at t=2 until the t=0 cohort moves on
+  std::string config =
+      "<in_commods> <val>spent_fuel</val> </in_commods>"
+      "<out_commod>dry_spent</out_commod>"
+      "<residence_times> <val>2</val> <val>0</val> </residence_times>"
+      "<stage_capacities> <val>15</val> <val>1e299</val> </stage_capacities>";
+
+  int simdur = 4;
+  cyclus::MockSim sim(cyclus::AgentSpec(":cycamore:StagedStorage"), config,
+                      simdur);
+  sim.AddSource("spent_fuel").capacity(10).Finalize();
+  int id = sim.Run();
+
+  std::vector<Cond> conds;
+  conds.push_back(Cond("Commodity", "==", std::string("spent_fuel")));
+  conds.push_back(Cond("Time", "==", 2));
+  QueryResult qr = sim.db().Query("Transactions", &conds);
+  EXPECT_EQ(0, qr.rows.size());
+
+  int n;
+  double qty;
+  TransSum(sim, "spent_fuel", &n, &qty);
+  EXPECT_DOUBLE_EQ(25, qty);
+}
+
+TEST(StagedStorageTests, StageCountMismatch) {
+  std::string config =
+      "<in_commods> <val>spent_fuel</val> </in_commods>"
+      "<out_commod>dry_spent</out_commod>"
+      "<residence_times> <val>2</val> <val>0</val> </residence_times>"
+      "<stage_throughputs> <val>1</val> </stage_throughputs>";
+
+  int simdur = 1;
+  cyclus::MockSim sim(cyclus::AgentSpec(":cycamore:StagedStorage"), config,
+                      simdur);
+  EXPECT_THROW(sim.Run(), cyclus::ValueError);
+}
+
+}  // namespace cycamore
+
+// - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+cyclus::Agent* StagedStorageConstructor(cyclus::Context* ctx) {
+  return new cycamore::StagedStorage(ctx);
+}
+
+// required to get functionality in cyclus agent unit tests library
+#ifndef CYCLUS_AGENT_TESTS_CONNECTED
+int ConnectAgentTests();
+static int cyclus_agent_tests_connected = ConnectAgentTests();
+#define CYCLUS_AGENT_TESTS_CONNECTED cyclus_agent_tests_connected
+#endif  // CYCLUS_AGENT_TESTS_CONNECTED
+
+INSTANTIATE_TEST_CASE_P(StagedStorageFac, FacilityTests,
+                        ::testing::Values(&StagedStorageConstructor));
+
+INSTANTIATE_TEST_CASE_P(StagedStorageFac, AgentTests,
+                        ::testing::Values(&StagedStorageConstructor));
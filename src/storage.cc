@@ -2,10 +2,13 @@
 // Implements the Storage class
 #include "storage.h"
 
+#include <algorithm>
+
 namespace storage {
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-Storage::Storage(cyclus::Context* ctx) : cyclus::Facility(ctx) {
+Storage::Storage(cyclus::Context* ctx)
+    : cyclus::Facility(ctx), entry_head(0), ready_head_(0) {
   cyclus::Warn<cyclus::EXPERIMENTAL_WARNING>(
       "The Storage Facility is experimental.");
 };
@@ -72,9 +75,12 @@ void Storage::EnterNotify() {
   buy_policy.Start();
 
   if (out_commods.size() == 1) {
-    sell_policy.Init(this, &stocks, std::string("stocks"))
-        .Set(out_commods.front())
-        .Start();
+    // in hub mode stocks are traded directly, see GetMatlBids
+    if (!hub_mode) {
+      sell_policy.Init(this, &stocks, std::string("stocks"))
+          .Set(out_commods.front())
+          .Start();
+    }
   } else {
     std::stringstream ss;
     ss << "out_commods has " << out_commods.size() << " values, expected 1.";
@@ -126,17 +132,123 @@ void Storage::Tick() {
 void Storage::Tock() {
   LOG(cyclus::LEV_INFO3, "ComCnv") << prototype() << " is tocking {";
 
-  BeginProcessing_();  // place unprocessed inventory into processing
+  if (residence_time == 0 && processing.empty() && ready.empty()) {
+    PassThrough_(throughput);  // place inventory directly into stocks
+  } else {
+    BeginProcessing_();  // place unprocessed inventory into processing
+
+    if (ready_time() >= 0 || residence_time == 0 && !inventory.empty()) {
+      ReadyMatl_(ready_time());  // place processing into ready
+    }
 
-  if (ready_time() >= 0 || residence_time == 0 && !inventory.empty()) {
-    ReadyMatl_(ready_time());  // place processing into ready
+    ProcessMat_(throughput);  // place ready into stocks
   }
 
-  ProcessMat_(throughput);  // place ready into stocks
-
   LOG(cyclus::LEV_INFO3, "ComCnv") << "}";
 }
 
+//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+std::set<cyclus::BidPortfolio<cyclus::Material>::Ptr> Storage::GetMatlBids(
+    cyclus::CommodMap<cyclus::Material>::type& commod_requests) {
+  using cyclus::BidPortfolio;
+  using cyclus::CapacityConstraint;
+  using cyclus::Material;
+  using cyclus::Request;
+
+  std::set<BidPortfolio<Material>::Ptr> ports;
+  std::string commod = out_commods.front();
+  if (!hub_mode || stocks.quantity() <= cyclus::eps_rsrc() ||
+      commod_requests.count(commod) == 0) {
+    return ports;
+  }
+
+  // trades are cut from a single pop of stocks, so stocks are merged (and
+  // decayed to now) up front to bid with the composition that actually ships
+  if (stocks.count() > 1) {
+    stocks.Push(cyclus::toolkit::Squash(stocks.PopN(stocks.count())));
+  }
+  if (decay_stored) {
+    stocks.Peek()->Decay(context()->time());
+  }
+
+  double max_qty = stocks.quantity();
+  cyclus::Composition::Ptr comp = stocks.Peek()->comp();
+  BidPortfolio<Material>::Ptr port(new BidPortfolio<Material>());
+
+  // every offer carries the composition of stocks, so requests for the same
+  // quantity can share one offer however many requesters there are
+  std::map<double, Material::Ptr> offers;
+  std::vector<Request<Material>*>& requests = commod_requests[commod];
+  std::vector<Request<Material>*>::iterator it;
+  for (it = requests.begin(); it != requests.end(); ++it) {
+    Request<Material>* req = *it;
+    double qty = std::min(req->target()->quantity(), max_qty);
+    if (qty <= cyclus::eps_rsrc()) {
+      continue;
+    }
+    Material::Ptr& offer = offers[qty];
+    if (!offer) {
+      offer = Material::CreateUntracked(qty, comp);
+    }
+    port->AddBid(req, offer, this);
+  }
+  if (offers.empty()) {
+    return ports;
+  }
+
+  CapacityConstraint<Material> cc(max_qty);
+  port->AddConstraint(cc);
+  ports.insert(port);
+
+  LOG(cyclus::LEV_INFO3, "ComCnv") << prototype() << " is bidding up to "
+                                   << max_qty << " kg of " << commod
+                                   << " to " << requests.size()
+                                   << " requests with " << offers.size()
+                                   << " offers";
+  return ports;
+}
+
+//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void Storage::GetMatlTrades(
+    const std::vector<cyclus::Trade<cyclus::Material> >& trades,
+    std::vector<std::pair<cyclus::Trade<cyclus::Material>,
+                          cyclus::Material::Ptr> >& responses) {
+  using cyclus::Material;
+
+  double tot = 0;
+  for (int i = 0; i < trades.size(); ++i) {
+    tot += trades[i].amt;
+  }
+  tot = std::min(tot, stocks.quantity());
+  if (tot <= cyclus::eps_rsrc()) {
+    return;  // only offers above eps_rsrc are made, see GetMatlBids
+  }
+
+  // stocks were merged when bidding, so this pop is cut from one material
+  // with the offered composition
+  Material::Ptr mat;
+  try {
+    mat = stocks.Pop(tot, cyclus::eps_rsrc());
+  } catch (cyclus::Error& e) {
+    e.msg(Agent::InformErrorMsg(e.msg()));
+    throw e;
+  }
+  if (decay_stored) {
+    mat->Decay(context()->time());
+  }
+
+  int last = trades.size() - 1;
+  for (int i = 0; i < last; ++i) {
+    double qty = std::min(trades[i].amt, mat->quantity());
+    responses.push_back(std::make_pair(trades[i], mat->ExtractQty(qty)));
+  }
+  responses.push_back(std::make_pair(trades[last], mat));
+
+  LOG(cyclus::LEV_INFO5, "ComCnv") << prototype() << " sent " << tot
+                                   << " kg of " << out_commods.front()
+                                   << " in " << trades.size() << " trades";
+}
+
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 void Storage::AddMat_(cyclus::Material::Ptr mat) {
   LOG(cyclus::LEV_INFO5, "ComCnv") << prototype() << " is initially holding "
@@ -157,19 +269,70 @@ void Storage::AddMat_(cyclus::Material::Ptr mat) {
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 void Storage::BeginProcessing_() {
-  while (inventory.count() > 0) {
-    try {
-      processing.Push(inventory.Pop());
-      entry_times.push_back(context()->time());
+  if (inventory.count() == 0) {
+    return;
+  }
 
-      LOG(cyclus::LEV_DEBUG2, "ComCnv")
-          << "Storage " << prototype()
-          << " added resources to processing at t= " << context()->time();
-    } catch (cyclus::Error& e) {
-      e.msg(Agent::InformErrorMsg(e.msg()));
-      throw e;
+  int n = inventory.count();
+  try {
+    if (discrete_handling) {
+      processing.Push(inventory.PopN(n));
+    } else {
+      processing.Push(cyclus::toolkit::Squash(inventory.PopN(n)));
+      n = 1;
+    }
+
+    LOG(cyclus::LEV_DEBUG2, "ComCnv")
+        << "Storage " << prototype()
+        << " added resources to processing at t= " << context()->time();
+  } catch (cyclus::Error& e) {
+    e.msg(Agent::InformErrorMsg(e.msg()));
+    throw e;
+  }
+
+  int t = context()->time();
+  if (entry_times.size() > entry_head && entry_times.back() == t) {
+    entry_counts.back() += n;
+  } else {
+    entry_times.push_back(t);
+    entry_counts.push_back(n);
+  }
+}
+
+//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void Storage::PassThrough_(double cap) {
+  using cyclus::toolkit::MatVec;
+
+  if (inventory.empty()) {
+    return;
+  }
+
+  try {
+    MatVec mats = inventory.PopN(inventory.count());
+    if (!discrete_handling) {
+      mats = MatVec(1, cyclus::toolkit::Squash(mats));
+    }
+
+    double qty = 0;
+    for (int i = 0; i < mats.size(); ++i) {
+      qty += mats[i]->quantity();
+    }
+
+    if (qty <= cap) {
+      ToStocks_(mats);
+      LOG(cyclus::LEV_INFO1, "ComCnv") << "Storage " << prototype()
+                                       << " passed resources"
+                                       << " from inventory to stocks"
+                                       << " at t= " << context()->time();
+      return;
     }
+    PushReady_(mats);
+  } catch (cyclus::Error& e) {
+    e.msg(Agent::InformErrorMsg(e.msg()));
+    throw e;
   }
+
+  ProcessMat_(cap);  // the excess over cap waits in ready
 }
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -185,16 +348,19 @@ void Storage::ProcessMat_(double cap) {
 
       if (discrete_handling) {
         if (max_pop == ready.quantity()) {
-          stocks.Push(ready.PopN(ready.count()));
+          ToStocks_(ready.PopN(ready.count()));
+          ready_cum_.assign(1, 0);
+          ready_head_ = 0;
         } else {
-          double cap_pop = ready.Peek()->quantity();
-          while (cap_pop <= max_pop && !ready.empty()) {
-            stocks.Push(ready.Pop());
-            cap_pop += ready.empty() ? 0 : ready.Peek()->quantity();
+          int n = ReadyFit_(max_pop);
+          if (n > 0) {
+            ToStocks_(ready.PopN(n));
+            ready_head_ += n;
           }
         }
       } else {
-        stocks.Push(ready.Pop(max_pop, cyclus::eps_rsrc()));
+        ToStocks_(cyclus::toolkit::MatVec(
+            1, ready.Pop(max_pop, cyclus::eps_rsrc())));
       }
 
       LOG(cyclus::LEV_INFO1, "ComCnv") << "Storage " << prototype()
@@ -208,18 +374,92 @@ void Storage::ProcessMat_(double cap) {
   }
 }
 
+//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void Storage::ToStocks_(cyclus::toolkit::MatVec mats) {
+  if (decay_stored) {
+    // each material remembers when it last decayed, and compositions cache
+    // their decay results by elapsed time, so a cohort of like materials
+    // only solves the decay chain once
+    int t = context()->time();
+    for (int i = 0; i < mats.size(); ++i) {
+      mats[i]->Decay(t);
+    }
+  }
+  stocks.Push(mats);
+}
+
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 void Storage::ReadyMatl_(int time) {
   using cyclus::toolkit::ResBuf;
 
   int to_ready = 0;
+  int head = entry_head;
+  while (head < entry_times.size() && entry_times[head] <= time) {
+    to_ready += entry_counts[head];
+    ++head;
+  }
+  if (head == entry_head) {
+    return;
+  }
 
-  while (!entry_times.empty() && entry_times.front() <= time) {
-    entry_times.pop_front();
-    ++to_ready;
+  entry_head = head;
+  if (entry_head > entry_times.size() - entry_head) {
+    // drop the matured prefix once it outgrows the live cohorts
+    entry_times.erase(entry_times.begin(), entry_times.begin() + entry_head);
+    entry_counts.erase(entry_counts.begin(), entry_counts.begin() + entry_head);
+    entry_head = 0;
   }
 
-  ready.Push(processing.PopN(to_ready));
+  PushReady_(processing.PopN(to_ready));
+}
+
+//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void Storage::PushReady_(cyclus::toolkit::MatVec mats) {
+  if (discrete_handling && ready_cum_.size() == ready_head_ + ready.count() + 1) {
+    for (int i = 0; i < mats.size(); ++i) {
+      ready_cum_.push_back(ready_cum_.back() + mats[i]->quantity());
+    }
+  }
+  ready.Push(mats);
+}
+
+//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+// Compares a quantity against a ready_cum_ entry's total above base.  Prefix
+// sums are only ever differenced, so a material that exactly fits rounds the
+// same way no matter how far the index has advanced.
+struct AboveBase {
+  explicit AboveBase(double base) : base(base) {}
+  bool operator()(double qty, double cum) const { return qty < cum - base; }
+  double base;
+};
+
+int Storage::ReadyFit_(double cap) {
+  if (ready_cum_.size() != ready_head_ + ready.count() + 1) {
+    IndexReady_();
+  } else if (ready_head_ > ready.count()) {
+    // drop the released prefix once it outgrows the live part of the index
+    ready_cum_.erase(ready_cum_.begin(), ready_cum_.begin() + ready_head_);
+    ready_head_ = 0;
+  }
+
+  std::vector<double>::iterator first = ready_cum_.begin() + ready_head_ + 1;
+  std::vector<double>::iterator last =
+      std::upper_bound(first, ready_cum_.end(), cap + cyclus::eps_rsrc(),
+                       AboveBase(ready_cum_[ready_head_]));
+  return last - first;
+}
+
+//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+void Storage::IndexReady_() {
+  ready_cum_.clear();
+  ready_cum_.reserve(ready.count() + 1);
+  ready_cum_.push_back(0);
+  cyclus::toolkit::MatVec mats = ready.PopN(ready.count());
+  ready.Push(mats);
+  for (int i = 0; i < mats.size(); i++) {
+    ready_cum_.push_back(ready_cum_.back() + mats[i]->quantity());
+  }
+  ready_head_ = 0;
 }
 
 // - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -98,23 +98,59 @@ class Storage
   /// The handleTick function specific to the Storage.
   virtual void Tock();
 
+  /// In hub mode, offers stocks on out_commods with a single portfolio whose
+  /// bids share one offer per distinct requested quantity
+  virtual std::set<cyclus::BidPortfolio<cyclus::Material>::Ptr> GetMatlBids(
+      cyclus::CommodMap<cyclus::Material>::type& commod_requests);
+
+  /// In hub mode, fulfils all matched trades from one split of stocks
+  virtual void GetMatlTrades(
+      const std::vector<cyclus::Trade<cyclus::Material> >& trades,
+      std::vector<std::pair<cyclus::Trade<cyclus::Material>,
+                            cyclus::Material::Ptr> >& responses);
+
  protected:
   ///   @brief adds a material into the incoming commodity inventory
   ///   @param mat the material to add to the incoming inventory.
   ///   @throws if there is trouble with pushing to the inventory buffer.
   void AddMat_(cyclus::Material::Ptr mat);
 
-  /// @brief Move all unprocessed inventory to processing
+  /// @brief Move all unprocessed inventory to processing as part of the
+  /// current time step's cohort.  When discrete_handling is off the moved
+  /// materials are combined into one.
   void BeginProcessing_();
 
   /// @brief Move as many ready resources as allowable into stocks
   /// @param cap current throughput capacity 
   void ProcessMat_(double cap);
 
+  /// @brief Move all unprocessed inventory straight into stocks, bounded by
+  /// cap, with any excess queued in ready.  Only valid when residence_time is
+  /// zero and nothing is held in processing or ready, where it gives the same
+  /// result as BeginProcessing_, ReadyMatl_ and ProcessMat_ in turn.
+  /// @param cap current throughput capacity
+  void PassThrough_(double cap);
+
+  /// @brief pushes mats into ready, extending the cumulative quantity index
+  void PushReady_(cyclus::toolkit::MatVec mats);
+
+  /// @brief pushes mats into stocks, first decaying them up to the current
+  /// time if decay_stored is set
+  void ToStocks_(cyclus::toolkit::MatVec mats);
+
   /// @brief move ready resources from processing to ready at a certain time
   /// @param time the time of interest
   void ReadyMatl_(int time);
 
+  /// @brief returns the number of whole materials at the front of ready
+  /// whose total quantity does not exceed cap (within eps_rsrc), found by
+  /// binary search over the cumulative quantity index of ready
+  /// @param cap current throughput capacity
+  int ReadyFit_(double cap);
+
+  /// @brief rebuilds the cumulative quantity index of ready from scratch
+  void IndexReady_();
+
     /* --- Storage Members --- */
 
   /// @brief current maximum amount that can be added to processing
@@ -190,6 +226,24 @@ class Storage
                       "uilabel":"Batch Handling"}
   bool discrete_handling;                    
 
+  #pragma cyclus var {"default": False,\
+                      "tooltip":"Bool to determine if stored material decays",\
+                      "doc":"If true, material decays for the time it is held in this facility. "\
+                            "Decay is applied lazily, once for each material as it is moved to stocks, "\
+                            "so materials waiting out their residence time cost nothing. "\
+                            "Default to false (no decay).",\
+                      "uilabel":"Decay Stored Material"}
+  bool decay_stored;
+
+  #pragma cyclus var {"default": False,\
+                      "tooltip":"Bool to aggregate bidding for many downstream requesters",\
+                      "doc":"If true, stocks are offered with one capacity constrained bid portfolio in "\
+                            "which requests for the same quantity share a single offer, and all trades "\
+                            "in a time step are filled from one split of stocks. Intended for hubs "\
+                            "feeding many downstream facilities. Default to false (use a sell policy).",\
+                      "uilabel":"Hub Mode"}
+  bool hub_mode;
+
   #pragma cyclus var {"tooltip":"Incoming material buffer"}
   cyclus::toolkit::ResBuf<cyclus::Material> inventory;
 
@@ -199,10 +253,23 @@ class Storage
   #pragma cyclus var {"tooltip":"Buffer for material held for required residence_time"}
   cyclus::toolkit::ResBuf<cyclus::Material> ready;
 
-  //// list of input times for materials entering the processing buffer
+  //// entry time of each cohort of materials in the processing buffer,
+  //// oldest first.  All materials entering processing in the same time step
+  //// form one cohort.  Cohorts before entry_head have already matured.
+  #pragma cyclus var{"default": [],\
+                      "internal": True}
+  std::vector<int> entry_times;
+
+  //// number of materials in the processing buffer belonging to each cohort
+  //// in entry_times
   #pragma cyclus var{"default": [],\
                       "internal": True}
-  std::list<int> entry_times;
+  std::vector<int> entry_counts;
+
+  //// index in entry_times of the oldest cohort still in processing
+  #pragma cyclus var{"default": 0,\
+                      "internal": True}
+  int entry_head;
 
   #pragma cyclus var {"tooltip":"Buffer for material still waiting for required residence_time"}
   cyclus::toolkit::ResBuf<cyclus::Material> processing;
@@ -213,6 +280,12 @@ class Storage
   //// A policy for sending material
   cyclus::toolkit::MatlSellPolicy sell_policy;
 
+  // cumulative quantities of the discrete materials in ready, front to back,
+  // with ready_cum_[ready_head_] the base for the current front material.
+  // Rebuilt from ready whenever it is out of sync - no need to be a state var
+  std::vector<double> ready_cum_;
+  int ready_head_;
+
 
   friend class StorageTest;
 };
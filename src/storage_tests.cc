@@ -1,5 +1,8 @@
 #include <gtest/gtest.h>
 
+#include <cmath>
+#include <sstream>
+
 #include "storage_tests.h"
 
 namespace storage {
@@ -23,6 +26,7 @@ void StorageTest::InitParameters(){
   max_inv_size = 200;
   throughput = 20;
   discrete_handling = 0;
+  decay_stored = 0;
 
   cyclus::CompMap v;
   v[922350000] = 1;
@@ -39,6 +43,7 @@ void StorageTest::SetUpStorage(){
   src_facility_->max_inv_size = max_inv_size;
   src_facility_->throughput = throughput;
   src_facility_->discrete_handling = discrete_handling;
+  src_facility_->decay_stored = decay_stored;
 }
 
 void StorageTest::TestInitState(Storage* fac){
@@ -81,6 +86,30 @@ void StorageTest::TestCurrentCap(Storage* fac, double inv){
   EXPECT_EQ(inv, fac->current_capacity());
 }
 
+void StorageTest::TestStocksFrac(Storage* fac, int nuc, double frac){
+
+  Material::Ptr m = fac->stocks.Peek();
+  cyclus::toolkit::MatQuery mq(m);
+  EXPECT_NEAR(frac, mq.mass_frac(nuc), 1e-4);
+}
+
+void StorageTest::TestCohorts(Storage* fac, std::vector<int> times,
+    std::vector<int> counts){
+
+  // only cohorts from entry_head on are still in processing
+  std::vector<int> live_times(fac->entry_times.begin() + fac->entry_head,
+                              fac->entry_times.end());
+  std::vector<int> live_counts(fac->entry_counts.begin() + fac->entry_head,
+                               fac->entry_counts.end());
+  EXPECT_EQ(times, live_times);
+  EXPECT_EQ(counts, live_counts);
+  int n = 0;
+  for (int i = 0; i < counts.size(); ++i) {
+    n += counts[i];
+  }
+  EXPECT_EQ(n, fac->processing.count());
+}
+
 void StorageTest::TestReadyTime(Storage* fac, int t){
 
   EXPECT_EQ(t, fac->ready_time());
@@ -190,6 +219,46 @@ TEST_F(StorageTest, NoProcessTime) {
   TestBuffers(src_facility_,0,0,0,cap);
 }
 
+TEST_F(StorageTest, PassThrough) {
+  // with no residence time material skips processing entirely, and the
+  // excess over throughput waits in ready
+  residence_time = 0;
+  SetUpStorage();
+  double cap = throughput;
+  cyclus::Composition::Ptr rec = tc_.get()->GetRecipe(in_r1);
+  TestAddMat(src_facility_, cyclus::Material::CreateUntracked(cap, rec));
+  TestAddMat(src_facility_, cyclus::Material::CreateUntracked(0.5*cap, rec));
+  src_facility_->Tock();
+  TestCohorts(src_facility_, std::vector<int>(), std::vector<int>());
+  TestBuffers(src_facility_,0,0,0.5*cap,cap);
+
+  tc_.get()->time(1);
+  TestAddMat(src_facility_, cyclus::Material::CreateUntracked(cap, rec));
+  src_facility_->Tock();
+  TestBuffers(src_facility_,0,0,0.5*cap,2*cap);
+
+  tc_.get()->time(2);
+  src_facility_->Tock();
+  TestBuffers(src_facility_,0,0,0,2.5*cap);
+}
+
+TEST_F(StorageTest, DiscretePassThrough) {
+  residence_time = 0;
+  discrete_handling = 1;
+  SetUpStorage();
+  cyclus::Composition::Ptr rec = tc_.get()->GetRecipe(in_r1);
+  TestAddMat(src_facility_, cyclus::Material::CreateUntracked(8, rec));
+  TestAddMat(src_facility_, cyclus::Material::CreateUntracked(15, rec));
+  src_facility_->Tock();
+  TestCohorts(src_facility_, std::vector<int>(), std::vector<int>());
+  TestBuffers(src_facility_,0,0,15,8);
+
+  tc_.get()->time(1);
+  TestAddMat(src_facility_, cyclus::Material::CreateUntracked(2, rec));
+  src_facility_->Tock();
+  TestBuffers(src_facility_,0,0,0,25);
+}
+
 TEST_F(StorageTest, NoConvert) {
 // Make sure no conversion occurs
   double cap = throughput;
@@ -209,6 +278,36 @@ TEST_F(StorageTest, NoConvert) {
   TestStocks(src_facility_,in_rec);
 }
 
+TEST_F(StorageTest, DecayStored) {
+  // Co60 (5.27 year half-life) held for residence_time months
+  cyclus::Env::SetNucDataPath();
+  cyclus::CompMap v;
+  v[270600000] = 1;
+  cyclus::Composition::Ptr co60 = cyclus::Composition::CreateFromMass(v);
+  double lambda = std::log(2.0) / (5.2714 * 365.25 * 24 * 3600);
+  double t = residence_time * tc_.get()->dt();
+  double remain = std::exp(-lambda * t);
+
+  // without decay_stored the composition is left untouched
+  TestAddMat(src_facility_, cyclus::Material::CreateUntracked(1, co60));
+  src_facility_->Tock();
+  tc_.get()->time(residence_time);
+  src_facility_->Tock();
+  TestStocksFrac(src_facility_, 270600000, 1);
+
+  delete src_facility_;
+  src_facility_ = new Storage(tc_.get());
+  decay_stored = 1;
+  SetUpStorage();
+  tc_.get()->time(0);
+  TestAddMat(src_facility_, cyclus::Material::CreateUntracked(1, co60));
+  src_facility_->Tock();
+  tc_.get()->time(residence_time);
+  src_facility_->Tock();
+  TestStocksFrac(src_facility_, 270600000, remain);
+  TestStocksFrac(src_facility_, 280600000, 1 - remain);
+}
+
 TEST_F(StorageTest, MultipleSmallBatches) {
   // Add first small batch
   double cap = throughput;
@@ -246,6 +345,105 @@ TEST_F(StorageTest, MultipleSmallBatches) {
 }
 
 
+TEST_F(StorageTest, Cohorts) {
+  // materials entering processing in the same time step share one cohort
+  // and, in continuous mode, are combined into a single material
+  double cap = throughput;
+  cyclus::Composition::Ptr rec = tc_.get()->GetRecipe(in_r1);
+  for (int i = 0; i < 3; ++i) {
+    TestAddMat(src_facility_, cyclus::Material::CreateUntracked(0.1*cap, rec));
+  }
+  src_facility_->Tock();
+  std::vector<int> times(1, 0);
+  std::vector<int> counts(1, 1);
+  TestCohorts(src_facility_, times, counts);
+
+  tc_.get()->time(1);
+  for (int i = 0; i < 2; ++i) {
+    TestAddMat(src_facility_, cyclus::Material::CreateUntracked(0.1*cap, rec));
+  }
+  src_facility_->Tock();
+  times.push_back(1);
+  counts.push_back(1);
+  TestCohorts(src_facility_, times, counts);
+  TestBuffers(src_facility_,0,0.5*cap,0,0);
+
+  // only the matured cohort moves on
+  tc_.get()->time(residence_time);
+  src_facility_->Tock();
+  times.erase(times.begin());
+  counts.erase(counts.begin());
+  TestCohorts(src_facility_, times, counts);
+  TestBuffers(src_facility_,0,0.2*cap,0,0.3*cap);
+
+  tc_.get()->time(residence_time+1);
+  src_facility_->Tock();
+  TestCohorts(src_facility_, std::vector<int>(), std::vector<int>());
+  TestBuffers(src_facility_,0,0,0,0.5*cap);
+}
+
+TEST_F(StorageTest, DiscreteCohorts) {
+  // discrete materials keep their identity but are still counted per cohort
+  discrete_handling = 1;
+  SetUpStorage();
+  double cap = throughput;
+  cyclus::Composition::Ptr rec = tc_.get()->GetRecipe(in_r1);
+  for (int i = 0; i < 3; ++i) {
+    TestAddMat(src_facility_, cyclus::Material::CreateUntracked(0.1*cap, rec));
+  }
+  src_facility_->Tock();
+  tc_.get()->time(1);
+  for (int i = 0; i < 2; ++i) {
+    TestAddMat(src_facility_, cyclus::Material::CreateUntracked(0.1*cap, rec));
+  }
+  src_facility_->Tock();
+
+  std::vector<int> times;
+  times.push_back(0);
+  times.push_back(1);
+  std::vector<int> counts;
+  counts.push_back(3);
+  counts.push_back(2);
+  TestCohorts(src_facility_, times, counts);
+
+  tc_.get()->time(residence_time);
+  src_facility_->Tock();
+  TestCohorts(src_facility_, std::vector<int>(1, 1), std::vector<int>(1, 2));
+  TestBuffers(src_facility_,0,0.2*cap,0,0.3*cap);
+}
+
+TEST_F(StorageTest, DiscreteRelease) {
+  // throughput limited releases move only whole materials, oldest first
+  discrete_handling = 1;
+  SetUpStorage();
+  cyclus::Composition::Ptr rec = tc_.get()->GetRecipe(in_r1);
+  double qtys[] = {3, 5, 4, 6, 7, 2, 9, 8};
+  for (int i = 0; i < 8; ++i) {
+    TestAddMat(src_facility_, cyclus::Material::CreateUntracked(qtys[i], rec));
+  }
+  src_facility_->Tock();
+
+  // 3 + 5 + 4 + 6 = 18 fits under the throughput of 20, adding 7 does not
+  tc_.get()->time(residence_time);
+  src_facility_->Tock();
+  TestBuffers(src_facility_,0,0,26,18);
+
+  // 7 + 2 + 9 = 18 fits, adding 8 does not
+  tc_.get()->time(residence_time+1);
+  src_facility_->Tock();
+  TestBuffers(src_facility_,0,0,8,36);
+
+  // new arrivals queue behind the materials left in ready
+  tc_.get()->time(residence_time+2);
+  TestAddMat(src_facility_, cyclus::Material::CreateUntracked(1, rec));
+  src_facility_->Tock();
+  TestBuffers(src_facility_,0,1,0,44);
+
+  tc_.get()->time(2*residence_time+2);
+  src_facility_->Tock();
+  TestBuffers(src_facility_,0,0,0,45);
+}
+
 TEST_F(StorageTest, ChangeCapacity) {
   // src_facility_->discrete_handling_(0);
   max_inv_size = 10000;
@@ -420,6 +618,79 @@ TEST_F(StorageTest, BehaviorTest){
 
 }
 
+TEST_F(StorageTest, HubMode){
+  // Hub mode serves any number of requesters the same as the sell policy
+  int nsinks[] = {1, 5, 20};
+  for (int i = 0; i < 3; ++i) {
+    for (int hub = 0; hub < 2; ++hub) {
+      std::stringstream config;
+      config << "   <in_commods> <val>spent_fuel</val> </in_commods> "
+             << "   <out_commods> <val>dry_spent</val> </out_commods> "
+             << "   <hub_mode>" << hub << "</hub_mode>";
+
+      int simdur = 3;
+      cyclus::MockSim sim(cyclus::AgentSpec (":cycamore:Storage"),
+                          config.str(), simdur);
+      sim.AddSource("spent_fuel").capacity(100).Finalize();
+      for (int j = 0; j < nsinks[i]; ++j) {
+        sim.AddSink("dry_spent").capacity(1).Finalize();
+      }
+      int id = sim.Run();
+
+      // stocks are filled at t=0 and every sink takes 1 kg at t=1 and t=2
+      cyclus::SqlStatement::Ptr stmt = sim.db().db().Prepare(
+          "SELECT COUNT(*), SUM(r.Quantity) FROM Transactions AS t"
+          " INNER JOIN Resources AS r ON r.ResourceId = t.ResourceId"
+          " WHERE t.Commodity = 'dry_spent';"
+          );
+      stmt->Step();
+      EXPECT_EQ(2 * nsinks[i], stmt->GetInt(0))
+          << nsinks[i] << " sinks, hub_mode=" << hub;
+      EXPECT_NEAR(2 * nsinks[i], stmt->GetDouble(1), 1e-6)
+          << nsinks[i] << " sinks, hub_mode=" << hub;
+    }
+  }
+}
+
+TEST_F(StorageTest, HubModeMixedStocks){
+  // stocks holding different compositions are merged before bidding, so
+  // every requester gets the composition that was offered
+  std::string config =
+    "   <in_commods> <val>spent_fuel</val> </in_commods> "
+    "   <out_commods> <val>dry_spent</val> </out_commods> "
+    "   <residence_time>0</residence_time> "
+    "   <discrete_handling>1</discrete_handling> "
+    "   <hub_mode>1</hub_mode>";
+
+  cyclus::CompMap v;
+  v[922350000] = 1;
+  cyclus::Composition::Ptr c235 = cyclus::Composition::CreateFromMass(v);
+  v.clear();
+  v[922380000] = 1;
+  cyclus::Composition::Ptr c238 = cyclus::Composition::CreateFromMass(v);
+
+  int simdur = 2;
+  cyclus::MockSim sim(cyclus::AgentSpec (":cycamore:Storage"), config, simdur);
+  sim.AddSource("spent_fuel").recipe("u235").capacity(5).lifetime(1).Finalize();
+  sim.AddSource("spent_fuel").recipe("u238").capacity(5).lifetime(1).Finalize();
+  sim.AddSink("dry_spent").capacity(2).Finalize();
+  sim.AddSink("dry_spent").capacity(3).Finalize();
+  sim.AddRecipe("u235", c235);
+  sim.AddRecipe("u238", c238);
+  int id = sim.Run();
+
+  std::vector<cyclus::Cond> conds;
+  conds.push_back(cyclus::Cond("SenderId", "==", id));
+  cyclus::QueryResult qr = sim.db().Query("Transactions", &conds);
+  ASSERT_EQ(2, qr.rows.size());
+  for (int i = 0; i < qr.rows.size(); ++i) {
+    cyclus::Material::Ptr m = sim.GetMaterial(qr.GetVal<int>("ResourceId", i));
+    cyclus::toolkit::MatQuery mq(m);
+    EXPECT_NEAR(0.5, mq.mass_frac(922350000), 1e-10);
+    EXPECT_NEAR(0.5, mq.mass_frac(922380000), 1e-10);
+  }
+}
+
 TEST_F(StorageTest, MultipleCommods){
   // Verify Storage accepting Multiple Commods
 
@@ -28,6 +28,9 @@ class StorageTest : public ::testing::Test {
   void TestStocks(storage::Storage* fac, cyclus::CompMap v);
   void TestReadyTime(storage::Storage* fac, int t);
   void TestCurrentCap(storage::Storage* fac, double inv);
+  void TestStocksFrac(storage::Storage* fac, int nuc, double frac);
+  void TestCohorts(storage::Storage* fac, std::vector<int> times,
+      std::vector<int> counts);
 
   std::vector<std::string> in_c1, out_c1;
   std::string in_r1;
@@ -35,6 +38,7 @@ class StorageTest : public ::testing::Test {
   int residence_time;
   double throughput, max_inv_size;
   bool discrete_handling;
+  bool decay_stored;
 };
 } // namespace storage
 #endif // STORAGE_TESTS_H_